@@ -277,6 +277,32 @@ bool common::isPureMessage(const ::google::protobuf::FieldDescriptor *field)
     return field->type() == FieldDescriptor::TYPE_MESSAGE && !field->is_map() && !field->is_repeated() && !common::isQtType(field);
 }
 
+bool common::isTypedField(const ::google::protobuf::FieldDescriptor *field)
+{
+    //Maps, repeated messages and enums, and Qt types are serialized using reflective path
+    switch (field->type()) {
+    case FieldDescriptor::TYPE_MESSAGE:
+        return isPureMessage(field);
+    case FieldDescriptor::TYPE_ENUM:
+    case FieldDescriptor::TYPE_BOOL:
+        return !field->is_repeated();
+    case FieldDescriptor::TYPE_GROUP:
+        return false;
+    default:
+        return true;
+    }
+}
+
+bool common::hasTypedFields(const ::google::protobuf::Descriptor *message)
+{
+    for (int i = 0; i < message->field_count(); i++) {
+        if (isTypedField(message->field(i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
 TypeMap common::produceTypeMap(const FieldDescriptor *field, const Descriptor *scope)
 {
     TypeMap typeMap;
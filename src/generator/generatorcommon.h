@@ -86,6 +86,8 @@ struct common {
     static bool hasQmlAlias(const ::google::protobuf::FieldDescriptor *field);
     static bool isQtType(const ::google::protobuf::FieldDescriptor *field);
     static bool isPureMessage(const ::google::protobuf::FieldDescriptor *field);
+    static bool isTypedField(const ::google::protobuf::FieldDescriptor *field);
+    static bool hasTypedFields(const ::google::protobuf::Descriptor *message);
 
     using InterateMessageLogic = std::function<void(const ::google::protobuf::FieldDescriptor *, PropertyMap &)>;
     static void iterateMessageFields(const ::google::protobuf::Descriptor *message, InterateMessageLogic callback) {
@@ -35,6 +35,7 @@ static const std::string CommentsGenerationOption("COMMENTS");
 static const std::string FolderGenerationOption("FOLDER");
 static const std::string FieldEnumGenerationOption("FIELDENUM");
 static const std::string ExtraNamespaceGenerationOption("EXTRA_NAMESPACE");
+static const std::string TypedSerializersGenerationOption("TYPED");
 
 using namespace ::QtProtobuf::generator;
 
@@ -43,6 +44,7 @@ GeneratorOptions::GeneratorOptions() : mIsMulti(false)
   , mGenerateComments(false)
   , mIsFolder(false)
   , mGenerateFieldEnum(false)
+  , mGenerateTypedSerializers(false)
 {
 }
 
@@ -66,6 +68,9 @@ void GeneratorOptions::parseFromEnv(const std::string &options)
         } else if (option.compare(FieldEnumGenerationOption) == 0) {
             QT_PROTOBUF_DEBUG("set mGenerateFieldEnum: true");
             mGenerateFieldEnum = true;
+        } else if (option.compare(TypedSerializersGenerationOption) == 0) {
+            QT_PROTOBUF_DEBUG("set mGenerateTypedSerializers: true");
+            mGenerateTypedSerializers = true;
         } else if (option.find(ExtraNamespaceGenerationOption) == 0) {
             QT_PROTOBUF_DEBUG("set mGenerateFieldEnum: true");
             std::vector<std::string> compositeOption = utils::split(options, '=');
@@ -51,6 +51,7 @@ public:
     bool generateComments() const { return mGenerateComments; }
     bool isFolder() const { return mIsFolder; }
     bool generateFieldEnum() const { return mGenerateFieldEnum; }
+    bool generateTypedSerializers() const { return mGenerateTypedSerializers; }
     const std::string &extraNamespace() const { return mExtraNamespace; }
 
 private:
@@ -59,6 +60,7 @@ private:
     bool mGenerateComments;
     bool mIsFolder;
     bool mGenerateFieldEnum;
+    bool mGenerateTypedSerializers;
     std::string mExtraNamespace;
 };
 
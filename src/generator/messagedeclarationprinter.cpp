@@ -339,6 +339,9 @@ void MessageDeclarationPrinter::printPrivateMethods()
             mPrinter->Print(propertyMap, Templates::NonScriptableSetterTemplate);
         }
     });
+    if (GeneratorOptions::instance().generateTypedSerializers() && common::hasTypedFields(mDescriptor)) {
+        mPrinter->Print(Templates::TypedSerializersDeclarationTemplate);
+    }
     Outdent();
 }
 
@@ -28,6 +28,8 @@
 #include <google/protobuf/descriptor.h>
 #include "generatoroptions.h"
 
+#include <algorithm>
+
 using namespace QtProtobuf::generator;
 using namespace ::google::protobuf;
 
@@ -56,6 +58,7 @@ void MessageDefinitionPrinter::printClassDefinitionPrivate()
     printMoveSemantic();
     printComparisonOperators();
     printGetters();
+    printTypedSerializers();
 }
 
 void MessageDefinitionPrinter::printClassDefinition()
@@ -89,7 +92,11 @@ void MessageDefinitionPrinter::printRegisterBody()
 }
 
 void MessageDefinitionPrinter::printFieldsOrdering() {
-    mPrinter->Print({{"type", mTypeMap["classname"]}}, Templates::FieldsOrderingContainerTemplate);
+    const char *containerTemplate = Templates::FieldsOrderingContainerTemplate;
+    if (GeneratorOptions::instance().generateTypedSerializers() && common::hasTypedFields(mDescriptor)) {
+        containerTemplate = Templates::TypedFieldsOrderingContainerTemplate;
+    }
+    mPrinter->Print({{"type", mTypeMap["classname"]}}, containerTemplate);
     Indent();
     for (int i = 0; i < mDescriptor->field_count(); i++) {
         const FieldDescriptor *field = mDescriptor->field(i);
@@ -203,10 +210,6 @@ void MessageDefinitionPrinter::printCopyFunctionality()
 
     const char *constructorTemplate = Templates::CopyConstructorDefinitionTemplate;
     const char *assignmentOperatorTemplate = Templates::AssignmentOperatorDefinitionTemplate;
-    if (mDescriptor->field_count() <= 0) {
-        constructorTemplate = Templates::EmptyCopyConstructorDefinitionTemplate;
-        assignmentOperatorTemplate = Templates::EmptyAssignmentOperatorDefinitionTemplate;
-    }
 
     mPrinter->Print(mTypeMap,
                     constructorTemplate);
@@ -218,6 +221,7 @@ void MessageDefinitionPrinter::printCopyFunctionality()
     mPrinter->Print("\n{\n");
 
     Indent();
+    mPrinter->Print(Templates::CopyUnknownFieldsTemplate);
     common::iterateMessageFields(mDescriptor, [&](const FieldDescriptor *field, const PropertyMap &propertyMap) {
         if (common::isPureMessage(field)) {
             mPrinter->Print(propertyMap, Templates::CopyComplexFieldTemplate);
@@ -230,6 +234,7 @@ void MessageDefinitionPrinter::printCopyFunctionality()
 
     mPrinter->Print(mTypeMap, assignmentOperatorTemplate);
     Indent();
+    mPrinter->Print(Templates::CopyUnknownFieldsTemplate);
     common::iterateMessageFields(mDescriptor, [&](const FieldDescriptor *field, const PropertyMap &propertyMap) {
         if (common::isPureMessage(field)) {
             mPrinter->Print(propertyMap, Templates::AssignComplexFieldTemplate);
@@ -248,10 +253,6 @@ void MessageDefinitionPrinter::printMoveSemantic()
 
     const char *constructorTemplate = Templates::MoveConstructorDefinitionTemplate;
     const char *assignmentOperatorTemplate = Templates::MoveAssignmentOperatorDefinitionTemplate;
-    if (mDescriptor->field_count() <= 0) {
-        constructorTemplate = Templates::EmptyMoveConstructorDefinitionTemplate;
-        assignmentOperatorTemplate = Templates::EmptyMoveAssignmentOperatorDefinitionTemplate;
-    }
 
     mPrinter->Print(mTypeMap,
                     constructorTemplate);
@@ -263,6 +264,7 @@ void MessageDefinitionPrinter::printMoveSemantic()
     mPrinter->Print("\n{\n");
 
     Indent();
+    mPrinter->Print(Templates::MoveUnknownFieldsTemplate);
     common::iterateMessageFields(mDescriptor, [&](const FieldDescriptor *field, const PropertyMap &propertyMap) {
         if (field->type() == FieldDescriptor::TYPE_MESSAGE
                 || field->type() == FieldDescriptor::TYPE_STRING
@@ -287,6 +289,7 @@ void MessageDefinitionPrinter::printMoveSemantic()
 
     mPrinter->Print(mTypeMap, assignmentOperatorTemplate);
     Indent();
+    mPrinter->Print(Templates::MoveUnknownFieldsTemplate);
     common::iterateMessageFields(mDescriptor, [&](const FieldDescriptor *field, const PropertyMap &propertyMap) {
         if (field->type() == FieldDescriptor::TYPE_MESSAGE
                 || field->type() == FieldDescriptor::TYPE_STRING
@@ -387,6 +390,64 @@ void MessageDefinitionPrinter::printGetters()
     });
 }
 
+void MessageDefinitionPrinter::printTypedSerializers()
+{
+    if (!GeneratorOptions::instance().generateTypedSerializers() || !common::hasTypedFields(mDescriptor)) {
+        return;
+    }
+
+    //Fields are written in order of field numbers
+    std::vector<const FieldDescriptor *> fields;
+    for (int i = 0; i < mDescriptor->field_count(); i++) {
+        fields.push_back(mDescriptor->field(i));
+    }
+    std::sort(fields.begin(), fields.end(), [](const FieldDescriptor *a, const FieldDescriptor *b) {
+        return a->number() < b->number();
+    });
+
+    mPrinter->Print(mTypeMap, Templates::TypedSerializerDefinitionBeginTemplate);
+    Indent();
+    for (auto field : fields) {
+        auto propertyMap = common::producePropertyMap(field, mDescriptor);
+        if (!common::isTypedField(field)) {
+            mPrinter->Print(propertyMap, Templates::TypedWritePropertyTemplate);
+        } else if (common::isPureMessage(field)) {
+            mPrinter->Print(propertyMap, Templates::TypedWriteMessageFieldTemplate);
+        } else if (field->type() == FieldDescriptor::TYPE_ENUM) {
+            mPrinter->Print(propertyMap, Templates::TypedWriteEnumFieldTemplate);
+        } else {
+            mPrinter->Print(propertyMap, Templates::TypedWriteFieldTemplate);
+        }
+    }
+    Outdent();
+    mPrinter->Print(Templates::SimpleBlockEnclosureTemplate);
+    mPrinter->Print("\n");
+
+    mPrinter->Print(mTypeMap, Templates::TypedDeserializerDefinitionBeginTemplate);
+    Indent();
+    Indent();
+    for (auto field : fields) {
+        if (!common::isTypedField(field)) {
+            continue;
+        }
+        auto propertyMap = common::producePropertyMap(field, mDescriptor);
+        if (common::isPureMessage(field)) {
+            mPrinter->Print(propertyMap, Templates::TypedReadMessageFieldTemplate);
+        } else if (field->type() == FieldDescriptor::TYPE_ENUM) {
+            mPrinter->Print(propertyMap, Templates::TypedReadEnumFieldTemplate);
+        } else if (field->is_repeated()) {
+            //Repeated fields are read in place, so elements are appended without copying whole list
+            mPrinter->Print(propertyMap, Templates::TypedReadRepeatedFieldTemplate);
+        } else {
+            mPrinter->Print(propertyMap, Templates::TypedReadFieldTemplate);
+        }
+    }
+    mPrinter->Print(Templates::TypedReadPropertyTemplate);
+    Outdent();
+    Outdent();
+    mPrinter->Print(Templates::TypedDeserializerDefinitionEndTemplate);
+}
+
 void MessageDefinitionPrinter::printDestructor()
 {
     mPrinter->Print(mTypeMap, Templates::RegistrarTemplate);
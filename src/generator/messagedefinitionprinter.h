@@ -53,6 +53,7 @@ private:
     void printMoveSemantic();
     void printComparisonOperators();
     void printGetters();
+    void printTypedSerializers();
     void printDestructor();
 
     void printClassDefinitionPrivate();
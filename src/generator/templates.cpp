@@ -118,11 +118,11 @@ const char *Templates::CopyConstructorDeclarationTemplate = "$classname$(const $
 const char *Templates::MoveConstructorDeclarationTemplate = "$classname$($classname$ &&other);\n";
 const char *Templates::CopyConstructorDefinitionTemplate = "$classname$::$classname$(const $classname$ &other) : QObject()";
 const char *Templates::MoveConstructorDefinitionTemplate = "$classname$::$classname$($classname$ &&other) : QObject()";
-const char *Templates::EmptyCopyConstructorDefinitionTemplate = "$classname$::$classname$(const $classname$ &) : QObject()";
-const char *Templates::EmptyMoveConstructorDefinitionTemplate = "$classname$::$classname$($classname$ &&) : QObject()";
 const char *Templates::DeletedCopyConstructorTemplate = "$classname$(const $classname$ &) = delete;\n";
 const char *Templates::DeletedMoveConstructorTemplate = "$classname$($classname$ &&) = delete;\n";
 const char *Templates::CopyFieldTemplate = "set$property_name_cap$(other.m_$property_name$);\n";
+const char *Templates::CopyUnknownFieldsTemplate = "m_unknownFields = other.m_unknownFields;\n";
+const char *Templates::MoveUnknownFieldsTemplate = "m_unknownFields = std::move(other.m_unknownFields);\n";
 const char *Templates::CopyComplexFieldTemplate = "if (m_$property_name$ != other.m_$property_name$) {\n"
                                                   "    *m_$property_name$ = *other.m_$property_name$;\n"
                                                   "}\n";
@@ -153,12 +153,10 @@ const char *Templates::EnumMoveFieldTemplate = "m_$property_name$ = other.m_$pro
 
 const char *Templates::AssignmentOperatorDeclarationTemplate = "$classname$ &operator =(const $classname$ &other);\n";
 const char *Templates::AssignmentOperatorDefinitionTemplate = "$classname$ &$classname$::operator =(const $classname$ &other)\n{\n";
-const char *Templates::EmptyAssignmentOperatorDefinitionTemplate = "$classname$ &$classname$::operator =(const $classname$ &)\n{\n";
 const char *Templates::AssignmentOperatorReturnTemplate = "return *this;\n";
 
 const char *Templates::MoveAssignmentOperatorDeclarationTemplate = "$classname$ &operator =($classname$ &&other);\n";
 const char *Templates::MoveAssignmentOperatorDefinitionTemplate = "$classname$ &$classname$::operator =($classname$ &&other)\n{\n";
-const char *Templates::EmptyMoveAssignmentOperatorDefinitionTemplate = "$classname$ &$classname$::operator =($classname$ &&)\n{\n";
 
 const char *Templates::EqualOperatorDeclarationTemplate = "bool operator ==(const $classname$ &other) const;\n";
 const char *Templates::EqualOperatorDefinitionTemplate = "bool $classname$::operator ==(const $classname$ &other) const\n{\n"
@@ -243,10 +241,58 @@ const char *Templates::NonScriptableSetterTemplate = "void set$property_name_cap
 const char *Templates::SignalsBlockTemplate = "\nsignals:\n";
 const char *Templates::SignalTemplate = "void $property_name$Changed();\n";
 
-const char *Templates::FieldsOrderingContainerTemplate = "const QtProtobuf::QProtobufMetaObject $type$::protobufMetaObject = QtProtobuf::QProtobufMetaObject($type$::staticMetaObject, $type$::propertyOrdering);\n"
+const char *Templates::FieldsOrderingContainerTemplate = "const QtProtobuf::QProtobufMetaObject $type$::protobufMetaObject($type$::staticMetaObject, $type$::propertyOrdering, $type$::unknownFieldsOf);\n"
                                                          "const QtProtobuf::QProtobufPropertyOrdering $type$::propertyOrdering = {";
+const char *Templates::TypedFieldsOrderingContainerTemplate = "const QtProtobuf::QProtobufMetaObject $type$::protobufMetaObject($type$::staticMetaObject, $type$::propertyOrdering, $type$::unknownFieldsOf, $type$::serializeFields, $type$::deserializeFields);\n"
+                                                              "const QtProtobuf::QProtobufPropertyOrdering $type$::propertyOrdering = {";
 const char *Templates::FieldOrderTemplate = "{$field_number$, {$property_number$, \"$json_name$\"}}";
 
+const char *Templates::TypedSerializersDeclarationTemplate = "static void serializeFields(const QObject *object, QtProtobuf::QProtobufTypedWriter &writer);\n"
+                                                             "static void deserializeFields(QObject *object, QtProtobuf::QProtobufTypedReader &reader);\n";
+const char *Templates::TypedSerializerDefinitionBeginTemplate = "void $classname$::serializeFields(const QObject *object, QtProtobuf::QProtobufTypedWriter &writer)\n{\n"
+                                                                "    const $classname$ *self = static_cast<const $classname$ *>(object);\n";
+const char *Templates::TypedWriteFieldTemplate = "writer.write($number$, self->m_$property_name$);\n";
+const char *Templates::TypedWriteEnumFieldTemplate = "writer.writeEnum($number$, QtProtobuf::int64(self->m_$property_name$));\n";
+const char *Templates::TypedWriteMessageFieldTemplate = "writer.writeMessage($number$, self->m_$property_name$);\n";
+const char *Templates::TypedWritePropertyTemplate = "writer.writeProperty($number$);\n";
+const char *Templates::TypedDeserializerDefinitionBeginTemplate = "void $classname$::deserializeFields(QObject *object, QtProtobuf::QProtobufTypedReader &reader)\n{\n"
+                                                                  "    $classname$ *self = static_cast<$classname$ *>(object);\n"
+                                                                  "    while (reader.next()) {\n"
+                                                                  "        switch (reader.fieldNumber()) {\n";
+const char *Templates::TypedReadFieldTemplate = "case $number$: {\n"
+                                                "    auto value = self->m_$property_name$;\n"
+                                                "    reader.read(value);\n"
+                                                "    self->set$property_name_cap$(value);\n"
+                                                "} break;\n";
+const char *Templates::TypedReadRepeatedFieldTemplate = "case $number$:\n"
+                                                        "    reader.read(self->m_$property_name$);\n"
+                                                        "    reader.notifyChanged();\n"
+                                                        "    break;\n";
+const char *Templates::TypedReadEnumFieldTemplate = "case $number$:\n"
+                                                    "    self->set$property_name_cap$(static_cast<$scope_type$>(reader.readEnum()._t));\n"
+                                                    "    break;\n";
+const char *Templates::TypedReadMessageFieldTemplate = "case $number$:\n"
+                                                       "    if (reader.isMerging()) {\n"
+                                                       "        reader.readMessage(self->m_$property_name$.get(), $scope_type$::protobufMetaObject);\n"
+                                                       "    } else if (reader.isLazy()) {\n"
+                                                       "        self->m_$property_name$.setSerializedData(reader.readSerializedMessage(), reader.options());\n"
+                                                       "        reader.notifyChanged();\n"
+                                                       "    } else {\n"
+                                                       "        $scope_type$ *value = QtProtobuf::QProtobufMessagePool::create<$scope_type$>();\n"
+                                                       "        if (reader.readMessage(value, $scope_type$::protobufMetaObject)) {\n"
+                                                       "            self->set$property_name_cap$_p(value);\n"
+                                                       "        } else {\n"
+                                                       "            delete value;\n"
+                                                       "        }\n"
+                                                       "    }\n"
+                                                       "    break;\n";
+const char *Templates::TypedReadPropertyTemplate = "default:\n"
+                                                   "    reader.readProperty();\n"
+                                                   "    break;\n";
+const char *Templates::TypedDeserializerDefinitionEndTemplate = "        }\n"
+                                                                "    }\n"
+                                                                "}\n\n";
+
 const char *Templates::EnumTemplate = "$type$";
 
 const char *Templates::SimpleBlockEnclosureTemplate = "}\n";
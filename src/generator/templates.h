@@ -102,11 +102,11 @@ public:
     static const char *MoveConstructorDeclarationTemplate;
     static const char *CopyConstructorDefinitionTemplate;
     static const char *MoveConstructorDefinitionTemplate;
-    static const char *EmptyCopyConstructorDefinitionTemplate;
-    static const char *EmptyMoveConstructorDefinitionTemplate;
     static const char *DeletedCopyConstructorTemplate;
     static const char *DeletedMoveConstructorTemplate;
     static const char *CopyFieldTemplate;
+    static const char *CopyUnknownFieldsTemplate;
+    static const char *MoveUnknownFieldsTemplate;
     static const char *CopyComplexFieldTemplate;
     static const char *AssignComplexFieldTemplate;
     static const char *MoveMessageFieldTemplate;
@@ -117,11 +117,9 @@ public:
     static const char *EnumMoveFieldTemplate;
     static const char *AssignmentOperatorDeclarationTemplate;
     static const char *AssignmentOperatorDefinitionTemplate;
-    static const char *EmptyAssignmentOperatorDefinitionTemplate;
     static const char *AssignmentOperatorReturnTemplate;
     static const char *MoveAssignmentOperatorDeclarationTemplate;
     static const char *MoveAssignmentOperatorDefinitionTemplate;
-    static const char *EmptyMoveAssignmentOperatorDefinitionTemplate;
     static const char *EqualOperatorDeclarationTemplate;
     static const char *EqualOperatorDefinitionTemplate;
     static const char *EmptyEqualOperatorDefinitionTemplate;
@@ -150,7 +148,22 @@ public:
     static const char *SignalsBlockTemplate;
     static const char *SignalTemplate;
     static const char *FieldsOrderingContainerTemplate;
+    static const char *TypedFieldsOrderingContainerTemplate;
     static const char *FieldOrderTemplate;
+
+    static const char *TypedSerializersDeclarationTemplate;
+    static const char *TypedSerializerDefinitionBeginTemplate;
+    static const char *TypedWriteFieldTemplate;
+    static const char *TypedWriteEnumFieldTemplate;
+    static const char *TypedWriteMessageFieldTemplate;
+    static const char *TypedWritePropertyTemplate;
+    static const char *TypedDeserializerDefinitionBeginTemplate;
+    static const char *TypedReadFieldTemplate;
+    static const char *TypedReadRepeatedFieldTemplate;
+    static const char *TypedReadEnumFieldTemplate;
+    static const char *TypedReadMessageFieldTemplate;
+    static const char *TypedReadPropertyTemplate;
+    static const char *TypedDeserializerDefinitionEndTemplate;
     static const char *EnumTemplate;
     static const char *SimpleBlockEnclosureTemplate;
     static const char *SemicolonBlockEnclosureTemplate;
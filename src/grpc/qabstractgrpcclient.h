@@ -208,20 +208,25 @@ private:
         QGrpcStatus status{QGrpcStatus::Ok};
         auto _serializer = serializer();
         if (_serializer != nullptr) {
-            try {
-                ret.deserialize(_serializer.get(), retData);
-            } catch (std::invalid_argument &) {
-                static const QLatin1String invalidArgumentErrorMessage("Response deserialization failed invalid field found");
-                status = {QGrpcStatus::InvalidArgument, invalidArgumentErrorMessage};
-                error(status);
-                qProtoCritical() << invalidArgumentErrorMessage;
-            } catch (std::out_of_range &) {
-                static const QLatin1String outOfRangeErrorMessage("Invalid size of received buffer");
-                status = {QGrpcStatus::OutOfRange, outOfRangeErrorMessage};
-                error(status);
-                qProtoCritical() << outOfRangeErrorMessage;
-            } catch (...) {
-                status = {QGrpcStatus::Internal, QLatin1String("Unknown exception caught during deserialization")};
+            //Malformed responses are reported without exceptions, so corrupted frames are cheap to reject
+            if (!ret.tryDeserialize(_serializer.get(), retData)) {
+                switch (_serializer->deserializationError()) {
+                case QtProtobuf::QAbstractProtobufSerializer::UnexpectedEndOfStreamError: {
+                    static const QLatin1String outOfRangeErrorMessage("Invalid size of received buffer");
+                    status = {QGrpcStatus::OutOfRange, outOfRangeErrorMessage};
+                    qProtoCritical() << outOfRangeErrorMessage;
+                } break;
+                case QtProtobuf::QAbstractProtobufSerializer::InvalidHeaderError:
+                case QtProtobuf::QAbstractProtobufSerializer::NoDeserializerError:
+                case QtProtobuf::QAbstractProtobufSerializer::InvalidFormatError: {
+                    static const QLatin1String invalidArgumentErrorMessage("Response deserialization failed invalid field found");
+                    status = {QGrpcStatus::InvalidArgument, invalidArgumentErrorMessage};
+                    qProtoCritical() << invalidArgumentErrorMessage;
+                } break;
+                default:
+                    status = {QGrpcStatus::Internal, QLatin1String("Unknown error occurred during deserialization")};
+                    break;
+                }
                 error(status);
             }
         } else {
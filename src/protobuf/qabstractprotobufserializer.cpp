@@ -27,43 +27,79 @@
 #include <QVariant>
 #include <QMetaObject>
 #include <QMutex>
+#include <QRunnable>
 #include <QSemaphore>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "qabstractprotobufserializer.h"
+#include "qprotobufmetaobject.h"
 
 using namespace QtProtobuf;
 
 namespace  {
 
-const int MaximumSimultaniousThreads = 64;
 /*!
  * \private
- * \brief The HandlersRegistry is container to store mapping between metatype identifier and serialization handlers.
+ * \brief The HandlersRegistry is flat table that maps metatype identifier to serialization handlers.
+ *
+ * \details Table is indexed by metatype identifier and split to chunks allocated on demand. Lookup is two
+ *          atomic loads without locking. Registered handlers are never released while registry exists, so
+ *          pointers returned by findHandler stay valid even if handler for same type is registered again.
+ *          Once registry is frozen, registered handlers are not replaced anymore.
  */
 struct HandlersRegistry {
+    static constexpr int ChunkSize = 256;
+    static constexpr int ChunksCount = 1024;
 
-    HandlersRegistry() : m_readLock(MaximumSimultaniousThreads) {
+    struct Chunk {
+        std::atomic<const QtProtobufPrivate::SerializationHandler *> handlers[ChunkSize] = {};
+    };
 
+    HandlersRegistry() : m_chunks{}, m_frozen(false) {}
+    ~HandlersRegistry() {
+        for (auto &chunk : m_chunks) {
+            delete chunk.load(std::memory_order_relaxed);
+        }
     }
 
     void registerHandler(int userType, const QtProtobufPrivate::SerializationHandler &handlers) {
+        if (userType < 0 || userType >= ChunkSize * ChunksCount) {
+            qProtoCritical() << "Unable to register serialization handler for metatype" << userType << "out of range";
+            Q_ASSERT_X(false, "HandlersRegistry", "Metatype identifier is out of range");
+            return;
+        }
+
         QMutexLocker locker(&m_writeLock);
-        QSemaphoreReleaser releaser(m_readLock, MaximumSimultaniousThreads);
-        m_readLock.acquire(MaximumSimultaniousThreads);
-        m_registry[userType] = handlers;
+        auto &chunkPointer = m_chunks[userType / ChunkSize];
+        Chunk *chunk = chunkPointer.load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            chunk = new Chunk;
+            chunkPointer.store(chunk, std::memory_order_release);
+        }
+        if (m_frozen && chunk->handlers[userType % ChunkSize].load(std::memory_order_relaxed) != nullptr) {
+            qProtoWarning() << "Serialization handler for metatype" << QMetaType::typeName(userType)
+                            << "is not replaced, handlers registry is frozen";
+            return;
+        }
+        m_storage.emplace_back(new QtProtobufPrivate::SerializationHandler(handlers));
+        chunk->handlers[userType % ChunkSize].store(m_storage.back().get(), std::memory_order_release);
     }
 
-    QtProtobufPrivate::SerializationHandler findHandler(int userType) {
-        auto handler = empty;
-        QMutexLocker locker(&m_writeLock);
-        QSemaphoreReleaser releaser(m_readLock, 1);
-        m_readLock.acquire();
-        locker.unlock();
-        auto it = m_registry.find(userType);
-        if (it != m_registry.end()) {
-            handler = it->second;
+    const QtProtobufPrivate::SerializationHandler *findHandler(int userType) const {
+        if (userType < 0 || userType >= ChunkSize * ChunksCount) {
+            return nullptr;
         }
-        return handler;
+        const Chunk *chunk = m_chunks[userType / ChunkSize].load(std::memory_order_acquire);
+        return chunk != nullptr ? chunk->handlers[userType % ChunkSize].load(std::memory_order_acquire) : nullptr;
+    }
+
+    void freeze() {
+        QMutexLocker locker(&m_writeLock);
+        m_frozen = true;
     }
 
     static HandlersRegistry &instance() {
@@ -71,13 +107,11 @@ struct HandlersRegistry {
         return _instance;
     }
 private:
-    QSemaphore m_readLock;
     QMutex m_writeLock;
-    std::unordered_map<int/*metatypeid*/, QtProtobufPrivate::SerializationHandler> m_registry;
-    static QtProtobufPrivate::SerializationHandler empty;
+    std::atomic<Chunk *> m_chunks[ChunksCount];
+    std::vector<std::unique_ptr<QtProtobufPrivate::SerializationHandler>> m_storage;
+    bool m_frozen;//Guarded by m_writeLock
 };
-
-QtProtobufPrivate::SerializationHandler HandlersRegistry::empty{};
 }
 
 void QtProtobufPrivate::registerHandler(int userType, const QtProtobufPrivate::SerializationHandler &handlers)
@@ -85,7 +119,76 @@ void QtProtobufPrivate::registerHandler(int userType, const QtProtobufPrivate::S
     HandlersRegistry::instance().registerHandler(userType, handlers);
 }
 
-QtProtobufPrivate::SerializationHandler QtProtobufPrivate::findHandler(int userType)
+void QtProtobufPrivate::freezeHandlers()
+{
+    HandlersRegistry::instance().freeze();
+}
+
+const QtProtobufPrivate::SerializationHandler *QtProtobufPrivate::findHandler(int userType)
 {
     return HandlersRegistry::instance().findHandler(userType);
 }
+
+void QAbstractProtobufSerializer::runBatch(int count, const std::function<void(int)> &job)
+{
+    //Range is split to chunks, several chunks per thread to even out load. Calling thread
+    //processes chunks as well, so batch is finished even if thread pool is busy.
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int chunksCount = qMin(count, qMax(1, pool->maxThreadCount()) * 4);
+    if (chunksCount <= 1) {
+        for (int i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::atomic<int> nextChunk(0);
+    auto processChunks = [&] {
+        for (int chunk = nextChunk++; chunk < chunksCount; chunk = nextChunk++) {
+            int begin = static_cast<int>(static_cast<qint64>(count) * chunk / chunksCount);
+            int end = static_cast<int>(static_cast<qint64>(count) * (chunk + 1) / chunksCount);
+            for (int i = begin; i < end; i++) {
+                job(i);
+            }
+        }
+    };
+
+    class Worker : public QRunnable {
+    public:
+        Worker(const std::function<void()> &work, QSemaphore &done) : m_work(work), m_done(done) {}
+        void run() override {
+            m_work();
+            m_done.release();
+        }
+    private:
+        const std::function<void()> &m_work;
+        QSemaphore &m_done;
+    };
+
+    //Workers are started only if pool has free threads, so nested batches don't wait for each other
+    QSemaphore done;
+    std::function<void()> work = processChunks;
+    int workersCount = 0;
+    int maxWorkersCount = qMin(chunksCount - 1, pool->maxThreadCount());
+    for (; workersCount < maxWorkersCount; workersCount++) {
+        Worker *worker = new Worker(work, done);
+        if (!pool->tryStart(worker)) {
+            delete worker;
+            break;
+        }
+    }
+    processChunks();
+    done.acquire(workersCount);
+}
+
+void QAbstractProtobufSerializer::clearMessage(QObject *object, const QProtobufMetaObject &metaObject)
+{
+    Q_ASSERT(object != nullptr);
+    //Default constructed value of property type, setters skip values that are equal to current ones
+    for (const auto &field : metaObject.fields()) {
+        field.metaProperty.write(object, QVariant(field.userType, nullptr));
+    }
+    if (metaObject.unknownFields != nullptr) {
+        metaObject.unknownFields(object)->clear();
+    }
+}
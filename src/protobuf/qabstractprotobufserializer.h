@@ -28,14 +28,23 @@
 #include <QObject>
 #include <QVariant>
 #include <QMetaObject>
+#include <QIODevice>
+#include <QSharedPointer>
+#include <QVector>
 
+#include <atomic>
 #include <unordered_map>
+#include <vector>
 #include <functional>
 #include <memory>
+#ifndef QT_NO_EXCEPTIONS
+#include <stdexcept>
+#endif
 
 #include "qtprotobuftypes.h"
 #include "qtprotobuflogging.h"
 #include "qprotobufselfcheckiterator.h"
+#include "qprotobuffieldmask.h"
 
 #include "qtprotobufglobal.h"
 
@@ -71,6 +80,17 @@ class QProtobufMetaObject;
 class Q_PROTOBUF_EXPORT QAbstractProtobufSerializer
 {
 public:
+    /*!
+     * \brief The DeserializationError enum describes reason of deserialization failure
+     */
+    enum DeserializationError {
+        NoError = 0, /*!< Message is deserialized successfully */
+        InvalidHeaderError, /*!< Field header or wire type is invalid */
+        NoDeserializerError, /*!< No deserializer is registered for field type */
+        UnexpectedEndOfStreamError, /*!< Field size exceeds size of input data */
+        InvalidFormatError /*!< Field value is malformed */
+    };
+
     /*!
      * \brief Serialization of a registered qtproto message object into byte-array
      *
@@ -85,31 +105,241 @@ public:
         return serializeMessage(object, T::protobufMetaObject);
     }
 
+    /*!
+     * \brief Serialization of fields of a registered qtproto message object selected by \a mask
+     *
+     * \details Fields that are not selected by \a mask are not written. Depending on serializer \a mask
+     *          may be ignored and all fields are serialized. Nothing is serialized if \a mask is invalid.
+     *
+     * \param[in] object Pointer to QObject containing message to be serialized
+     * \param[in] mask Mask of fields to be serialized
+     * \result serialized message
+     */
+    template<typename T>
+    QByteArray serialize(const QObject *object, const QProtobufFieldMask &mask) {
+        Q_ASSERT(object != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "serialize masked";
+        return serializeMaskedMessage(object, T::protobufMetaObject, mask);
+    }
+
+    /*!
+     * \brief Serialization of a registered qtproto message object directly into \a device
+     *
+     * \details Depending on serializer message is written by chunks of bounded size, without building
+     *          whole serialized message in memory
+     *
+     * \param[in] object Pointer to QObject containing message to be serialized
+     * \param[in] device Opened device that message is written to
+     * \result true if message is written completely
+     */
+    template<typename T>
+    bool serializeTo(const QObject *object, QIODevice *device) {
+        Q_ASSERT(object != nullptr);
+        Q_ASSERT(device != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "serializeTo";
+        return serializeMessageTo(object, T::protobufMetaObject, device);
+    }
+
+    /*!
+     * \brief Calculates size of serialized \a object without producing serialized data
+     *
+     * \details Result is equal to size of serialize() result. Depending on serializer size is
+     *          calculated without allocation of output buffer
+     *
+     * \param[in] object Pointer to QObject containing message to be measured
+     * \result Size of serialized message in bytes
+     */
+    template<typename T>
+    int serializedSize(const QObject *object) {
+        Q_ASSERT(object != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "serializedSize";
+        return serializedMessageSize(object, T::protobufMetaObject);
+    }
+
     /*!
      * \brief Deserialization of a byte-array into a registered qtproto message object
      *
      * \details Properties in a message are identified via ProtobufObjectPrivate::decodeHeader.
-     *          Bytes corresponding to unexpected properties are skipped without any exception
+     *          Bytes corresponding to unexpected properties are skipped without any exception.
+     *          In case if \a data is malformed, fields deserialized before failure are kept in \a object
+     *          and std::invalid_argument or std::out_of_range is thrown, unless Qt is built without
+     *          exceptions support. Use tryDeserialize() to handle malformed data without exceptions.
      *
      * \param[out] object Pointer to memory where result of deserialization should be injected
      * \param[in] data Bytes with serialized message
+     * \result true if message is deserialized successfully
      */
     template<typename T>
-    void deserialize(T *object, const QByteArray &data) {
+    bool deserialize(T *object, const QByteArray &data) {
+        bool ok = tryDeserialize<T>(object, data);
+        throwDeserializationError(ok);
+        return ok;
+    }
+
+    /*!
+     * \brief Deserialization of fields selected by \a mask from a byte-array into a registered qtproto message object
+     *
+     * \details Fields that are not selected by \a mask are skipped without construction of values and
+     *          keep default values in \a object. Failures are reported same way as by deserialize().
+     *
+     * \param[out] object Pointer to memory where result of deserialization should be injected
+     * \param[in] data Bytes with serialized message
+     * \param[in] mask Mask of fields to be deserialized
+     * \result true if message is deserialized successfully
+     */
+    template<typename T>
+    bool deserialize(T *object, const QByteArray &data, const QProtobufFieldMask &mask) {
+        Q_ASSERT(object != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "deserialize masked";
+        T newValue;
+        bool ok = deserializeMaskedMessage(&newValue, T::protobufMetaObject, data, mask);
+        *object = newValue;
+        throwDeserializationError(ok);
+        return ok;
+    }
+
+    /*!
+     * \brief Same as deserialize(), but never throws exceptions
+     *
+     * \details Reason of failure is available using deserializationError()
+     *
+     * \param[out] object Pointer to memory where result of deserialization should be injected
+     * \param[in] data Bytes with serialized message
+     * \result true if message is deserialized successfully
+     */
+    template<typename T>
+    bool tryDeserialize(T *object, const QByteArray &data) {
         Q_ASSERT(object != nullptr);
         qProtoDebug() << T::staticMetaObject.className() << "deserialize";
         //Initialize default object first and make copy aferwards, it's necessary to set default
         //values of properties that was not stored in data.
         T newValue;
-        try {
-            deserializeMessage(&newValue, T::protobufMetaObject, data);
-        } catch(...) {
-            *object = newValue;
-            throw;
-        }
+        bool ok = deserializeMessage(&newValue, T::protobufMetaObject, data);
         *object = newValue;
+        return ok;
+    }
+
+    /*!
+     * \brief Deserialization of a byte-array directly into existing registered qtproto message object
+     *
+     * \details Unlike deserialize() no temporary message is created and copied to \a object. Fields of \a object
+     *          are reset to default values first, after that \a data is merged into \a object same way as
+     *          mergeFrom() does. Failures are reported same way as by deserialize().
+     *
+     * \param[out] object Pointer to message object that will be filled with deserialized data
+     * \param[in] data Bytes with serialized message
+     * \result true if message is deserialized successfully
+     */
+    template<typename T>
+    bool deserializeInto(T *object, const QByteArray &data) {
+        Q_ASSERT(object != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "deserializeInto";
+        bool ok = deserializeMessageInto(object, T::protobufMetaObject, data);
+        throwDeserializationError(ok);
+        return ok;
+    }
+
+    /*!
+     * \brief Merges a byte-array into existing registered qtproto message object
+     *
+     * \details Follows protobuf merge semantics: singular fields present in \a data overwrite values of
+     *          \a object, repeated fields are appended to existing values, nested messages are merged
+     *          recursively into existing nested objects. Failures are reported same way as by deserialize().
+     *
+     * \param[out] object Pointer to message object that \a data is merged into
+     * \param[in] data Bytes with serialized message
+     * \result true if message is merged successfully
+     */
+    template<typename T>
+    bool mergeFrom(T *object, const QByteArray &data) {
+        Q_ASSERT(object != nullptr);
+        qProtoDebug() << T::staticMetaObject.className() << "mergeFrom";
+        bool ok = mergeMessage(object, T::protobufMetaObject, data);
+        throwDeserializationError(ok);
+        return ok;
     }
 
+    /*!
+     * \brief Serializes \a objects in parallel, using threads of QThreadPool::globalInstance()
+     *
+     * \details Serializer is used from several threads concurrently, QProtobufSerializer and
+     *          QProtobufJsonSerializer support it. Messages must not be modified until batch is serialized.
+     *
+     * \param[in] objects List of messages to be serialized
+     * \result List of serialized messages in order of \a objects
+     */
+    template<typename T>
+    QList<QByteArray> serializeBatch(const QList<QSharedPointer<T>> &objects) {
+        qProtoDebug() << T::staticMetaObject.className() << "serializeBatch" << objects.size();
+        QVector<QByteArray> result(objects.size());
+        QByteArray *out = result.data();
+        runBatch(objects.size(), [this, &objects, out](int index) {
+            Q_ASSERT(objects.at(index) != nullptr);
+            out[index] = serializeMessage(objects.at(index).data(), T::protobufMetaObject);
+        });
+        return result.toList();
+    }
+
+    /*!
+     * \brief Deserializes \a data into \a objects in parallel, using threads of QThreadPool::globalInstance()
+     *
+     * \details Each element of \a data is deserialized into element of \a objects with same index, same way
+     *          as deserializeInto() does, but exceptions are never thrown. Worker threads fill temporary
+     *          messages that have no connections, afterwards they are moved to \a objects in calling thread,
+     *          so change notifications are emitted from calling thread only.
+     *
+     * \param[out] objects List of messages to be filled with deserialized data, has same size as \a data
+     * \param[in] data List of serialized messages
+     * \result true if all messages are deserialized successfully
+     */
+    template<typename T>
+    bool deserializeBatch(const QList<QSharedPointer<T>> &objects, const QList<QByteArray> &data) {
+        Q_ASSERT(objects.size() == data.size());
+        qProtoDebug() << T::staticMetaObject.className() << "deserializeBatch" << objects.size();
+        //Fields of target are reset by deserializeInto() anyway, so default messages are filled instead of copies
+        std::vector<std::unique_ptr<T>> messages;
+        messages.reserve(static_cast<size_t>(objects.size()));
+        for (const auto &object : objects) {
+            Q_ASSERT(object != nullptr);
+            Q_UNUSED(object);
+            messages.emplace_back(new T);
+        }
+
+        std::atomic<bool> ok(true);
+        runBatch(objects.size(), [this, &messages, &data, &ok](int index) {
+            if (!deserializeMessageInto(messages[static_cast<size_t>(index)].get(), T::protobufMetaObject, data.at(index))) {
+                ok.store(false, std::memory_order_relaxed);
+            }
+        });
+
+        for (int i = 0; i < objects.size(); i++) {
+            *objects.at(i) = std::move(*messages[static_cast<size_t>(i)]);
+        }
+        return ok.load();
+    }
+
+    /*!
+     * \brief Returns reason of last deserialization failure in current thread or NoError if last
+     *        deserialization succeeded
+     */
+    virtual DeserializationError deserializationError() const {
+        return NoError;
+    }
+
+    /*!
+     * \brief Returns human-readable description of deserializationError()
+     */
+    virtual QString deserializationErrorString() const {
+        return QString();
+    }
+
+    /*!
+     * \brief Resets all fields of \a object to default values and drops its unknown fields
+     * \param object Message object to be cleared
+     * \param metaObject Protobuf meta information about \a object type
+     */
+    static void clearMessage(QObject *object, const QProtobufMetaObject &metaObject);
+
     virtual ~QAbstractProtobufSerializer() = default;
 
     /*!
@@ -121,14 +351,103 @@ public:
      */
     virtual QByteArray serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) const = 0;
 
+    /*!
+     * \brief serializeMessageTo Writes serialized \a object to \a device
+     *
+     * \details Default implementation writes result of serializeMessage() at once. Serializers may
+     *          reimplement this method to write message by chunks.
+     * \param object Message object to be serialized
+     * \param metaObject Protobuf meta information about \a object type
+     * \param device Opened device that message is written to
+     * \return true if message is written completely
+     */
+    virtual bool serializeMessageTo(const QObject *object, const QProtobufMetaObject &metaObject, QIODevice *device) const {
+        QByteArray data = serializeMessage(object, metaObject);
+        return device->write(data) == data.size();
+    }
+
+    /*!
+     * \brief serializeMaskedMessage Serializes fields of \a object selected by \a mask
+     *
+     * \details Default implementation serializes all fields if \a mask is valid
+     * \param object Message object to be serialized
+     * \param metaObject Protobuf meta information about \a object type
+     * \param mask Mask of fields to be serialized
+     * \return serialized message, empty if \a mask is invalid
+     */
+    virtual QByteArray serializeMaskedMessage(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufFieldMask &mask) const {
+        if (!mask.isValid()) {
+            return QByteArray();
+        }
+        return serializeMessage(object, metaObject);
+    }
+
+    /*!
+     * \brief serializedMessageSize Calculates size of serialized \a object
+     *
+     * \details Default implementation returns size of serializeMessage() result. Serializers may
+     *          reimplement this method to calculate size without producing serialized data.
+     * \param object Message object to be measured
+     * \param metaObject Protobuf meta information about \a object type
+     * \return Size of serialized message in bytes
+     */
+    virtual int serializedMessageSize(const QObject *object, const QProtobufMetaObject &metaObject) const {
+        return serializeMessage(object, metaObject).size();
+    }
+
     /*!
      * \brief serializeMessage
      * \param object
      * \param propertyOrdering
      * \param metaObject
-     * \return
+     * \return false if \a data is malformed
+     */
+    virtual bool deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const = 0;
+
+    /*!
+     * \brief mergeMessage Merges \a data into existing \a object
+     *
+     * \details Default implementation deserializes \a data into \a object without merge semantics for
+     *          repeated fields and nested messages. Serializers should reimplement this method to support
+     *          mergeFrom() and deserializeInto() properly.
+     * \param object Message object that \a data is merged into
+     * \param metaObject Protobuf meta information about \a object type
+     * \param data Bytes with serialized message
+     * \return false if \a data is malformed
+     */
+    virtual bool mergeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const {
+        return deserializeMessage(object, metaObject, data);
+    }
+
+    /*!
+     * \brief deserializeMessageInto Resets fields of \a object to default values and merges \a data into it
+     * \param object Message object to be filled with deserialized data
+     * \param metaObject Protobuf meta information about \a object type
+     * \param data Bytes with serialized message
+     * \return false if \a data is malformed
      */
-    virtual void deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const = 0;
+    virtual bool deserializeMessageInto(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const {
+        clearMessage(object, metaObject);
+        return mergeMessage(object, metaObject, data);
+    }
+
+    /*!
+     * \brief deserializeMaskedMessage Deserializes fields selected by \a mask from \a data into \a object
+     *
+     * \details Default implementation deserializes all fields if \a mask is valid
+     * \param object Message object to be filled with deserialized data
+     * \param metaObject Protobuf meta information about \a object type
+     * \param data Bytes with serialized message
+     * \param mask Mask of fields to be deserialized
+     * \return false if \a data is malformed or \a mask is invalid
+     */
+    virtual bool deserializeMaskedMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data,
+                                          const QProtobufFieldMask &mask) const {
+        if (!mask.isValid()) {
+            return false;
+        }
+        return deserializeMessage(object, metaObject, data);
+    }
 
     /*!
      * \brief serializeObject Serializes complete \a object according given \a propertyOrdering and \a metaObject
@@ -148,8 +467,9 @@ public:
      * \param[in] it Pointer to beging of buffer where object serialized data is located
      * \param[in] propertyOrdering Ordering of properties for given \a object
      * \param[in] metaProperty Information about property to be serialized
+     * \return false if serialized data is malformed
      */
-    virtual void deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const = 0;
+    virtual bool deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const = 0;
 
     /*!
      * \brief serializeListBegin Method called at the begining of object list serialization
@@ -262,16 +582,41 @@ public:
      * \param[out] value Buffer that will be used to collect new enum value
      * \param[in] metaEnum Information about enumeration type
      * \param[in] it Points to serialized raw key/value data
+     * \return false if serialized data is malformed
      */
-    virtual void deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const = 0;
+    virtual bool deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const = 0;
 
     /*!
      * \brief deserializeEnum Deserializes list of enum values from byte stream
      * \param[out] value QList that will be used to collect deserialized enum values
      * \param[in] metaEnum Information about enumeration type
      * \param[in] it Points to serialized raw key/value data
+     * \return false if serialized data is malformed
      */
-    virtual void deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const = 0;
+    virtual bool deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const = 0;
+
+private:
+    /*!
+     * \private
+     * \brief Calls \a job for each index in range [0, count) using threads of QThreadPool::globalInstance()
+     *        and calling thread, returns when all jobs are finished
+     */
+    static void runBatch(int count, const std::function<void(int)> &job);
+
+    void throwDeserializationError(bool ok) const {
+#ifndef QT_NO_EXCEPTIONS
+        //Exceptions are thrown at API boundary only, deserialization itself reports errors by return values
+        if (ok) {
+            return;
+        }
+        if (deserializationError() == UnexpectedEndOfStreamError) {
+            throw std::out_of_range(deserializationErrorString().toStdString());
+        }
+        throw std::invalid_argument(deserializationErrorString().toStdString());
+#else
+        Q_UNUSED(ok);
+#endif
+    }
 };
 /*! \} */
 }
@@ -287,9 +632,9 @@ template<typename T>
 static void qRegisterProtobufType() {
     T::registerTypes();
     QtProtobufPrivate::registerHandler(qMetaTypeId<T *>(), { QtProtobufPrivate::serializeObject<T>,
-            QtProtobufPrivate::deserializeObject<T>, QtProtobufPrivate::ObjectHandler });
+            QtProtobufPrivate::deserializeObject<T>, QtProtobufPrivate::ObjectHandler, QtProtobufPrivate::mergeObject<T> });
     QtProtobufPrivate::registerHandler(qMetaTypeId<QList<QSharedPointer<T>>>(), { QtProtobufPrivate::serializeList<T>,
-            QtProtobufPrivate::deserializeList<T>, QtProtobufPrivate::ListHandler });
+            QtProtobufPrivate::deserializeList<T>, QtProtobufPrivate::ListHandler, {}, qMetaTypeId<T *>() });
 }
 
 /*!
@@ -314,7 +659,7 @@ template<typename K, typename V,
          typename std::enable_if_t<std::is_base_of<QObject, V>::value, int> = 0>
 inline void qRegisterProtobufMapType() {
     QtProtobufPrivate::registerHandler(qMetaTypeId<QMap<K, QSharedPointer<V>>>(), { QtProtobufPrivate::serializeMap<K, V>,
-    QtProtobufPrivate::deserializeMap<K, V>, QtProtobufPrivate::MapHandler });
+    QtProtobufPrivate::deserializeMap<K, V>, QtProtobufPrivate::MapHandler, {}, qMetaTypeId<V *>() });
 }
 
 
@@ -35,6 +35,7 @@
 #include "qtprotobuftypes.h"
 #include "qtprotobuflogging.h"
 #include "qtprotobufglobal.h"
+#include "qprotobufmessagepool.h"
 
 namespace QtProtobuf {
     class QAbstractProtobufSerializer;
@@ -66,10 +67,37 @@ struct SerializationHandler {
     Serializer serializer; /*!< serializer assigned to class */
     Deserializer deserializer;/*!< deserializer assigned to class */
     HandlerType type;/*!< Serialization WireType */
+    Deserializer merger;/*!< deserializer that merges data into existing value, empty if type has no merge semantics */
+    int elementType = QMetaType::UnknownType;/*!< Meta type id of pointer to message type of list elements or map values, UnknownType for other types */
 };
 
-extern Q_PROTOBUF_EXPORT SerializationHandler findHandler(int userType);
+/*!
+ * \private
+ * \brief findHandler looks up serialization handler registered for \a userType
+ * \return nullptr if no handler registered for \a userType. Returned pointer stays valid until library is unloaded
+ */
+extern Q_PROTOBUF_EXPORT const SerializationHandler *findHandler(int userType);
 extern Q_PROTOBUF_EXPORT void registerHandler(int userType, const SerializationHandler &handlers);
+/*!
+ * \private
+ * \brief freezeHandlers forbids replacement of registered handlers, handlers of new types are still registered
+ */
+extern Q_PROTOBUF_EXPORT void freezeHandlers();
+
+/*!
+ * \private
+ * \brief valueRef returns reference to value of type T stored in \a variant
+ *
+ * \details \a variant is converted to T if it holds other type. Container is detached once, so
+ *          elements appended by repeated calls are added in place
+ */
+template <typename T>
+T &valueRef(QVariant &variant) {
+    if (variant.userType() != qMetaTypeId<T>()) {
+        variant = QVariant::fromValue<T>(variant.value<T>());
+    }
+    return *static_cast<T *>(variant.data());
+}
 
 /*!
  * \private
@@ -175,11 +203,30 @@ template <typename T,
           typename std::enable_if_t<std::is_base_of<QObject, T>::value, int> = 0>
 void deserializeObject(const QtProtobuf::QAbstractProtobufSerializer *serializer, QtProtobuf::QProtobufSelfcheckIterator &it, QVariant &to) {
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
-    T *value = new T;
-    serializer->deserializeObject(value, T::protobufMetaObject, it);
+    T *value = QtProtobuf::QProtobufMessagePool::create<T>();
+    if (!serializer->deserializeObject(value, T::protobufMetaObject, it)) {
+        delete value;
+        return;
+    }
     to = QVariant::fromValue<T *>(value);
 }
 
+/*!
+ * \private
+ * \brief default merger template for type T inherited of QObject. Deserializes data into object stored in \a to
+ */
+template <typename T,
+          typename std::enable_if_t<std::is_base_of<QObject, T>::value, int> = 0>
+void mergeObject(const QtProtobuf::QAbstractProtobufSerializer *serializer, QtProtobuf::QProtobufSelfcheckIterator &it, QVariant &to) {
+    Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
+    T *value = to.value<T *>();
+    if (value == nullptr) {
+        deserializeObject<T>(serializer, it, to);
+        return;
+    }
+    serializer->deserializeObject(value, T::protobufMetaObject, it);
+}
+
 /*!
  * \private
  * \brief default deserializer template for list of type T objects inherited of QObject
@@ -190,11 +237,11 @@ void deserializeList(const QtProtobuf::QAbstractProtobufSerializer *serializer,
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
     qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
-    V *newValue = new V;
-    QList<QSharedPointer<V>> list = previous.value<QList<QSharedPointer<V>>>();
-    if (serializer->deserializeListObject(newValue, V::protobufMetaObject, it)) {
-        list.append(QSharedPointer<V>(newValue));
-        previous.setValue(list);
+    //Object is taken from active message pool if any, otherwise object and its reference counter are
+    //allocated at once. Object is released if deserialization failed
+    QSharedPointer<V> newValue = QtProtobuf::QProtobufMessagePool::createShared<V>();
+    if (serializer->deserializeListObject(newValue.data(), V::protobufMetaObject, it)) {
+        valueRef<QList<QSharedPointer<V>>>(previous).append(newValue);
     }
 }
 
@@ -209,13 +256,11 @@ void deserializeMap(const QtProtobuf::QAbstractProtobufSerializer *serializer, Q
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
     qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
-    QMap<K, V> out = previous.value<QMap<K, V>>();
     QVariant key = QVariant::fromValue<K>(K());
     QVariant value = QVariant::fromValue<V>(V());
 
     if (serializer->deserializeMapPair(key, value, it)) {
-        out[key.value<K>()] = value.value<V>();
-        previous = QVariant::fromValue<QMap<K, V>>(out);
+        valueRef<QMap<K, V>>(previous)[key.value<K>()] = value.value<V>();
     }
 }
 
@@ -231,13 +276,11 @@ void deserializeMap(const QtProtobuf::QAbstractProtobufSerializer *serializer, Q
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
     qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
-    auto out = previous.value<QMap<K, QSharedPointer<V>>>();
     QVariant key = QVariant::fromValue<K>(K());
     QVariant value = QVariant::fromValue<V *>(nullptr);
 
     if (serializer->deserializeMapPair(key, value, it)) {
-        out[key.value<K>()] = QSharedPointer<V>(value.value<V *>());
-        previous = QVariant::fromValue<QMap<K, QSharedPointer<V>>>(out);
+        valueRef<QMap<K, QSharedPointer<V>>>(previous)[key.value<K>()] = QSharedPointer<V>(value.value<V *>());
     }
 }
 
@@ -251,7 +294,9 @@ template <typename T,
 void deserializeEnum(const QtProtobuf::QAbstractProtobufSerializer *serializer, QtProtobuf::QProtobufSelfcheckIterator &it, QVariant &to) {
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
     QtProtobuf::int64 intValue;
-    serializer->deserializeEnum(intValue, QMetaEnum::fromType<T>(), it);
+    if (!serializer->deserializeEnum(intValue, QMetaEnum::fromType<T>(), it)) {
+        return;
+    }
     to = QVariant::fromValue<T>(static_cast<T>(intValue._t));
 }
 
@@ -265,11 +310,12 @@ template <typename T,
 void deserializeEnumList(const QtProtobuf::QAbstractProtobufSerializer *serializer, QtProtobuf::QProtobufSelfcheckIterator &it, QVariant &previous) {
     Q_ASSERT_X(serializer != nullptr, "QAbstractProtobufSerializer", "Serializer is null");
     QList<QtProtobuf::int64> intList;
-    serializer->deserializeEnumList(intList, QMetaEnum::fromType<T>(), it);
-    QList<T> enumList = previous.value<QList<T>>();
+    if (!serializer->deserializeEnumList(intList, QMetaEnum::fromType<T>(), it)) {
+        return;
+    }
+    QList<T> &enumList = valueRef<QList<T>>(previous);
     for (auto intValue : intList) {
         enumList.append(static_cast<T>(intValue._t));
     }
-    previous = QVariant::fromValue<QList<T>>(enumList);
 }
 }
@@ -0,0 +1,184 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobuffieldmask.h"
+#include "qprotobufmetaobject.h"
+#include "qtprotobuflogging.h"
+
+#include <algorithm>
+
+using namespace QtProtobuf;
+
+namespace {
+//google.protobuf.FieldMask paths use field names of .proto file, json names are lowerCamelCase of them
+QString toJsonName(const QString &name)
+{
+    QString result;
+    result.reserve(name.size());
+    bool capitalizeNext = false;
+    for (const QChar &c : name) {
+        if (c == QLatin1Char('_')) {
+            capitalizeNext = true;
+        } else {
+            result.append(capitalizeNext ? c.toUpper() : c);
+            capitalizeNext = false;
+        }
+    }
+    return result;
+}
+}
+
+QProtobufFieldMask::QProtobufFieldMask(std::initializer_list<QList<int>> paths)
+{
+    for (const auto &path : paths) {
+        addPath(path);
+    }
+}
+
+QProtobufFieldMask QProtobufFieldMask::all()
+{
+    QProtobufFieldMask mask;
+    mask.m_all = true;
+    return mask;
+}
+
+QProtobufFieldMask QProtobufFieldMask::fromPaths(const QStringList &paths, const QProtobufMetaObject &metaObject, bool *ok)
+{
+    QProtobufFieldMask mask;
+    if (ok != nullptr) {
+        *ok = true;
+    }
+    for (const QString &path : paths) {
+        QList<int> fieldNumbers;
+        const QProtobufMetaObject *currentMetaObject = &metaObject;
+        for (const QString &name : path.split(QLatin1Char('.'))) {
+            if (currentMetaObject == nullptr) {
+                fieldNumbers.clear();
+                break;
+            }
+
+            const QProtobufFieldInfo *field = nullptr;
+            bool isNumber = false;
+            int fieldNumber = name.toInt(&isNumber);
+            if (isNumber) {
+                field = currentMetaObject->field(fieldNumber);
+            } else {
+                QString jsonName = toJsonName(name);
+                for (const auto &candidate : currentMetaObject->fields()) {
+                    QString candidateName = candidate.metaProperty.jsonPropertyName();
+                    if (candidateName == jsonName || candidateName == name) {
+                        field = &candidate;
+                        break;
+                    }
+                }
+            }
+
+            if (field == nullptr) {
+                fieldNumbers.clear();
+                break;
+            }
+            fieldNumbers.append(field->metaProperty.protoFieldIndex());
+            currentMetaObject = QProtobufMetaObject::forType(field->userType);
+            if (currentMetaObject == nullptr) {
+                //Repeated and map fields of messages are resolved to message type of elements
+                const QtProtobufPrivate::SerializationHandler *handler = QtProtobufPrivate::findHandler(field->userType);
+                if (handler != nullptr && handler->elementType != QMetaType::UnknownType) {
+                    currentMetaObject = QProtobufMetaObject::forType(handler->elementType);
+                }
+            }
+        }
+
+        if (fieldNumbers.isEmpty()) {
+            qProtoWarning() << "Field mask path" << path << "is not found in" << metaObject.staticMetaObject.className();
+            //Mask never falls back to selection of more fields than requested
+            QProtobufFieldMask invalid;
+            invalid.m_valid = false;
+            if (ok != nullptr) {
+                *ok = false;
+            }
+            return invalid;
+        }
+        mask.addPath(fieldNumbers);
+    }
+    return mask;
+}
+
+void QProtobufFieldMask::addPath(const QList<int> &path)
+{
+    if (m_all) {
+        return;
+    }
+
+    QProtobufFieldMask *mask = this;
+    for (int i = 0; i < path.size(); i++) {
+        auto it = mask->find(path[i]);
+        bool last = i == path.size() - 1;
+        if (it == mask->m_fields.end() || it->fieldNumber != path[i]) {
+            it = mask->m_fields.insert(it, {path[i], last ? nullptr : std::make_shared<QProtobufFieldMask>()});
+        } else if (last) {
+            it->subMask.reset();
+        } else if (it->subMask == nullptr) {
+            return;//Field is selected whole already
+        } else if (it->subMask.use_count() > 1) {
+            it->subMask = std::make_shared<QProtobufFieldMask>(*it->subMask);
+        }
+        mask = it->subMask.get();
+    }
+}
+
+bool QProtobufFieldMask::contains(int fieldNumber) const
+{
+    const QProtobufFieldMask *unused = nullptr;
+    return select(fieldNumber, unused);
+}
+
+bool QProtobufFieldMask::select(int fieldNumber, const QProtobufFieldMask *&subMask) const
+{
+    subMask = nullptr;
+    if (m_all) {
+        return true;
+    }
+
+    auto it = find(fieldNumber);
+    if (it == m_fields.end() || it->fieldNumber != fieldNumber) {
+        return false;
+    }
+    subMask = it->subMask.get();
+    return true;
+}
+
+std::vector<QProtobufFieldMask::Field>::iterator QProtobufFieldMask::find(int fieldNumber)
+{
+    return std::lower_bound(m_fields.begin(), m_fields.end(), fieldNumber, [](const Field &field, int number) {
+        return field.fieldNumber < number;
+    });
+}
+
+std::vector<QProtobufFieldMask::Field>::const_iterator QProtobufFieldMask::find(int fieldNumber) const
+{
+    return std::lower_bound(m_fields.begin(), m_fields.end(), fieldNumber, [](const Field &field, int number) {
+        return field.fieldNumber < number;
+    });
+}
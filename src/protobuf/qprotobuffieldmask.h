@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufFieldMask
+
+#include "qtprotobufglobal.h"
+
+#include <QList>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+namespace QtProtobuf {
+
+class QProtobufMetaObject;
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufFieldMask class selects subset of message fields that is serialized or deserialized
+ *
+ * \details Mask is set of paths of field numbers. Path selects field of message or, if path is longer than one
+ *          field number, field of nested message. Sub-paths of repeated and map fields are applied to each
+ *          element. Default constructed mask selects no fields, mask that selects all fields is created
+ *          using all().
+ *
+ * \code
+ * QProtobufFieldMask mask({{1}, {3, 2}});//Field 1 and field 2 of message stored in field 3
+ * QByteArray data = message.serialize(serializer, mask);
+ * \endcode
+ */
+class Q_PROTOBUF_EXPORT QProtobufFieldMask
+{
+public:
+    QProtobufFieldMask() = default;
+    QProtobufFieldMask(std::initializer_list<QList<int>> paths);
+
+    /*!
+     * \brief Creates mask that selects all fields
+     */
+    static QProtobufFieldMask all();
+
+    /*!
+     * \brief Creates mask from \a paths in google.protobuf.FieldMask format, e.g. "status" or "position.latitude"
+     *
+     * \details Path elements are field names or field numbers of message described by \a metaObject and
+     *          of nested messages, elements of repeated and map fields of messages are resolved same way.
+     *          If any of paths can't be resolved, invalid mask that selects no fields is returned and
+     *          \a ok is set to false.
+     */
+    static QProtobufFieldMask fromPaths(const QStringList &paths, const QProtobufMetaObject &metaObject, bool *ok = nullptr);
+
+    /*!
+     * \brief Adds \a path of field numbers to mask
+     */
+    void addPath(const QList<int> &path);
+
+    /*!
+     * \brief Returns false if mask is created from paths that can't be resolved
+     *
+     * \details Serializers don't write or read any fields using invalid mask and report failure
+     */
+    bool isValid() const { return m_valid; }
+
+    /*!
+     * \brief Returns true if mask selects no fields
+     */
+    bool isEmpty() const { return !m_all && m_fields.empty(); }
+
+    /*!
+     * \brief Returns true if mask selects all fields
+     */
+    bool selectsAll() const { return m_all; }
+
+    /*!
+     * \brief Returns true if field with \a fieldNumber is selected by mask
+     */
+    bool contains(int fieldNumber) const;
+
+    /*!
+     * \private
+     * \brief Looks up field with \a fieldNumber
+     * \param[out] subMask Mask of nested message fields, nullptr if field is selected whole
+     * \return true if field is selected by mask
+     */
+    bool select(int fieldNumber, const QProtobufFieldMask *&subMask) const;
+
+private:
+    struct Field {
+        int fieldNumber;
+        std::shared_ptr<QProtobufFieldMask> subMask;//nullptr if field is selected whole, shared by mask copies
+    };
+
+    std::vector<Field>::iterator find(int fieldNumber);
+    std::vector<Field>::const_iterator find(int fieldNumber) const;
+
+    std::vector<Field> m_fields;//Sorted by field number
+    bool m_all = false;
+    bool m_valid = true;
+};
+
+}
@@ -0,0 +1,432 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufjsoncodec_p.h"
+
+#include <array>
+#include <cstring>
+
+using namespace QtProtobuf;
+
+namespace {
+constexpr quint64 Ones = 0x0101010101010101ULL;
+constexpr quint64 HighBits = 0x8080808080808080ULL;
+constexpr quint64 Ones16 = 0x0001000100010001ULL;
+constexpr quint64 HighBits16 = 0x8000800080008000ULL;
+
+const char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char HexDigits[] = "0123456789abcdef";
+
+//Value of every character of base64 alphabet, characters out of alphabet are marked by high bit
+const std::array<quint8, 256> &base64Values()
+{
+    static const std::array<quint8, 256> values = [] {
+        std::array<quint8, 256> result;
+        result.fill(0x80);
+        for (quint8 i = 0; i < 64; i++) {
+            result[static_cast<uchar>(Base64Alphabet[i])] = i;
+        }
+        //URL-safe alphabet
+        result['-'] = 62;
+        result['_'] = 63;
+        return result;
+    }();
+    return values;
+}
+
+//Checks 4 UTF-16 code units at once if all of them are ASCII characters that are not escaped
+inline bool isPlainAscii(quint64 word)
+{
+    if ((word & (Ones16 * 0xff80)) != 0) {
+        return false;
+    }
+    quint64 quotes = word ^ (Ones16 * '"');
+    quint64 backslashes = word ^ (Ones16 * '\\');
+    quint64 result = ((word - Ones16 * 0x20) & ~word)
+            | ((quotes - Ones16) & ~quotes)
+            | ((backslashes - Ones16) & ~backslashes);
+    return (result & HighBits16) == 0;
+}
+
+//Checks 8 bytes at once if all of them are ASCII characters that are not escape sequences
+inline bool isPlainAscii(const uchar *data)
+{
+    quint64 word;
+    memcpy(&word, data, sizeof(word));
+    quint64 backslashes = word ^ (Ones * '\\');
+    return ((word | ((backslashes - Ones) & ~backslashes)) & HighBits) == 0;
+}
+
+inline bool needsEscape(ushort unit)
+{
+    return unit < 0x20 || unit == '"' || unit == '\\';
+}
+
+char *writeEscape(ushort unit, char *out)
+{
+    *out++ = '\\';
+    switch (unit) {
+    case '"': *out++ = '"'; break;
+    case '\\': *out++ = '\\'; break;
+    case '\b': *out++ = 'b'; break;
+    case '\f': *out++ = 'f'; break;
+    case '\n': *out++ = 'n'; break;
+    case '\r': *out++ = 'r'; break;
+    case '\t': *out++ = 't'; break;
+    default:
+        *out++ = 'u';
+        *out++ = '0';
+        *out++ = '0';
+        *out++ = HexDigits[(unit >> 4) & 0x0f];
+        *out++ = HexDigits[unit & 0x0f];
+        break;
+    }
+    return out;
+}
+
+int hexValue(uchar c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+int readCodeUnit(const uchar *it, const uchar *end)
+{
+    if (end - it < 4) {
+        return -1;
+    }
+    int result = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexValue(it[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        result = (result << 4) | digit;
+    }
+    return result;
+}
+
+//Resolves escape sequence that follows reverse solidus at it
+QChar *readEscape(const uchar *&it, const uchar *end, QChar *out)
+{
+    uchar c = it != end ? *it++ : '\0';
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+        *out++ = QLatin1Char(static_cast<char>(c));
+        break;
+    case 'b': *out++ = QLatin1Char('\b'); break;
+    case 'f': *out++ = QLatin1Char('\f'); break;
+    case 'n': *out++ = QLatin1Char('\n'); break;
+    case 'r': *out++ = QLatin1Char('\r'); break;
+    case 't': *out++ = QLatin1Char('\t'); break;
+    case 'u': {
+        int unit = readCodeUnit(it, end);
+        if (unit < 0) {
+            *out++ = QChar::ReplacementCharacter;
+            break;
+        }
+        it += 4;
+        if (QChar::isHighSurrogate(static_cast<uint>(unit))) {
+            int low = end - it >= 2 && it[0] == '\\' && it[1] == 'u' ? readCodeUnit(it + 2, end) : -1;
+            if (low >= 0 && QChar::isLowSurrogate(static_cast<uint>(low))) {
+                *out++ = QChar(static_cast<ushort>(unit));
+                *out++ = QChar(static_cast<ushort>(low));
+                it += 6;
+            } else {
+                *out++ = QChar::ReplacementCharacter;
+            }
+        } else if (QChar::isLowSurrogate(static_cast<uint>(unit))) {
+            *out++ = QChar::ReplacementCharacter;
+        } else {
+            *out++ = QChar(static_cast<ushort>(unit));
+        }
+    }
+        break;
+    default:
+        *out++ = QChar::ReplacementCharacter;
+        break;
+    }
+    return out;
+}
+
+inline bool isContinuation(uchar c)
+{
+    return (c & 0xc0) == 0x80;
+}
+
+//Decodes multibyte UTF-8 sequence at it, overlong forms, surrogates and code points above U+10FFFF are rejected
+bool readSequence(const uchar *&it, const uchar *end, QChar *&out)
+{
+    uchar c = *it;
+    uint codePoint = 0;
+    int length = 0;
+    uchar min = 0x80;
+    uchar max = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        length = 2;
+        codePoint = c & 0x1f;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        length = 3;
+        codePoint = c & 0x0f;
+        if (c == 0xe0) {
+            min = 0xa0;
+        } else if (c == 0xed) {
+            max = 0x9f;
+        }
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        length = 4;
+        codePoint = c & 0x07;
+        if (c == 0xf0) {
+            min = 0x90;
+        } else if (c == 0xf4) {
+            max = 0x8f;
+        }
+    } else {
+        return false;
+    }
+
+    if (end - it < length || it[1] < min || it[1] > max) {
+        return false;
+    }
+
+    for (int i = 1; i < length; i++) {
+        if (!isContinuation(it[i])) {
+            return false;
+        }
+        codePoint = (codePoint << 6) | (it[i] & 0x3f);
+    }
+    it += length;
+
+    if (QChar::requiresSurrogates(codePoint)) {
+        *out++ = QChar(QChar::highSurrogate(codePoint));
+        *out++ = QChar(QChar::lowSurrogate(codePoint));
+    } else {
+        *out++ = QChar(static_cast<ushort>(codePoint));
+    }
+    return true;
+}
+}
+
+void QProtobufJsonCodec::writeString(const QString &value, QByteArray &out)
+{
+    const QChar *it = value.constData();
+    const QChar *end = it + value.size();
+
+    //UTF-16 code unit takes up to 3 bytes in UTF-8, space for escape sequences is reserved when met
+    int begin = out.size();
+    out.resize(begin + value.size() * 3 + 2);
+    char *result = out.data() + begin;
+    *result++ = '"';
+    while (it != end) {
+        if (end - it >= 4) {
+            quint64 word;
+            memcpy(&word, it, sizeof(word));
+            if (isPlainAscii(word)) {
+                for (int i = 0; i < 4; i++) {
+                    result[i] = static_cast<char>(it[i].unicode());
+                }
+                result += 4;
+                it += 4;
+                continue;
+            }
+        }
+
+        ushort unit = it->unicode();
+        ++it;
+        if (unit < 0x80) {
+            if (!needsEscape(unit)) {
+                *result++ = static_cast<char>(unit);
+                continue;
+            }
+            //Escape sequence takes up to 6 bytes
+            int written = static_cast<int>(result - out.data());
+            int required = written + 6 + static_cast<int>(end - it) * 3 + 1;
+            if (required > out.size()) {
+                out.resize(required);
+                result = out.data() + written;
+            }
+            result = writeEscape(unit, result);
+        } else if (unit < 0x800) {
+            *result++ = static_cast<char>(0xc0 | (unit >> 6));
+            *result++ = static_cast<char>(0x80 | (unit & 0x3f));
+        } else if (QChar::isHighSurrogate(unit) && it != end && it->isLowSurrogate()) {
+            //Surrogate pair takes 4 bytes of reserved 6
+            uint codePoint = QChar::surrogateToUcs4(unit, it->unicode());
+            ++it;
+            *result++ = static_cast<char>(0xf0 | (codePoint >> 18));
+            *result++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+            *result++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+            *result++ = static_cast<char>(0x80 | (codePoint & 0x3f));
+        } else {
+            if (QChar::isSurrogate(unit)) {
+                unit = QChar::ReplacementCharacter;
+            }
+            *result++ = static_cast<char>(0xe0 | (unit >> 12));
+            *result++ = static_cast<char>(0x80 | ((unit >> 6) & 0x3f));
+            *result++ = static_cast<char>(0x80 | (unit & 0x3f));
+        }
+    }
+    *result++ = '"';
+    out.resize(static_cast<int>(result - out.data()));
+}
+
+bool QProtobufJsonCodec::readString(const char *data, int size, QString &value)
+{
+    //UTF-8 sequence and escape sequence never take less bytes than UTF-16 code units they are decoded to
+    QString result(size, Qt::Uninitialized);
+    QChar *out = result.data();
+    const uchar *it = reinterpret_cast<const uchar *>(data);
+    const uchar *end = it + size;
+    while (it != end) {
+        if (end - it >= 8 && isPlainAscii(it)) {
+            for (int i = 0; i < 8; i++) {
+                out[i] = QLatin1Char(static_cast<char>(it[i]));
+            }
+            out += 8;
+            it += 8;
+            continue;
+        }
+
+        uchar c = *it;
+        if (c == '\\') {
+            ++it;
+            out = readEscape(it, end, out);
+        } else if (c < 0x80) {
+            *out++ = QLatin1Char(static_cast<char>(c));
+            ++it;
+        } else if (!readSequence(it, end, out)) {
+            return false;
+        }
+    }
+    result.resize(static_cast<int>(out - result.constData()));
+    value = result;
+    return true;
+}
+
+void QProtobufJsonCodec::writeBase64(const char *data, int size, QByteArray &out)
+{
+    int begin = out.size();
+    out.resize(begin + (size + 2) / 3 * 4);
+    char *result = out.data() + begin;
+    const uchar *it = reinterpret_cast<const uchar *>(data);
+    const uchar *end = it + size;
+
+    //6 bytes are encoded to 8 characters at once
+    while (end - it >= 6) {
+        quint64 bits = (quint64(it[0]) << 40) | (quint64(it[1]) << 32) | (quint64(it[2]) << 24)
+                | (quint64(it[3]) << 16) | (quint64(it[4]) << 8) | quint64(it[5]);
+        for (int i = 0; i < 8; i++) {
+            result[i] = Base64Alphabet[(bits >> (42 - i * 6)) & 0x3f];
+        }
+        result += 8;
+        it += 6;
+    }
+
+    if (end - it >= 3) {
+        uint bits = (uint(it[0]) << 16) | (uint(it[1]) << 8) | uint(it[2]);
+        for (int i = 0; i < 4; i++) {
+            result[i] = Base64Alphabet[(bits >> (18 - i * 6)) & 0x3f];
+        }
+        result += 4;
+        it += 3;
+    }
+
+    if (it != end) {
+        uint bits = uint(it[0]) << 16;
+        if (end - it == 2) {
+            bits |= uint(it[1]) << 8;
+        }
+        result[0] = Base64Alphabet[(bits >> 18) & 0x3f];
+        result[1] = Base64Alphabet[(bits >> 12) & 0x3f];
+        result[2] = end - it == 2 ? Base64Alphabet[(bits >> 6) & 0x3f] : '=';
+        result[3] = '=';
+    }
+}
+
+bool QProtobufJsonCodec::readBase64(const char *data, int size, QByteArray &value)
+{
+    for (int padding = 0; padding < 2 && size > 0 && data[size - 1] == '='; padding++) {
+        --size;
+    }
+    //Single character of last quantum doesn't make a byte
+    if (size % 4 == 1) {
+        return false;
+    }
+
+    const std::array<quint8, 256> &values = base64Values();
+    QByteArray result(size / 4 * 3 + (size % 4 != 0 ? size % 4 - 1 : 0), Qt::Uninitialized);
+    char *out = result.data();
+    const uchar *it = reinterpret_cast<const uchar *>(data);
+    const uchar *end = it + size;
+    quint8 invalid = 0;
+
+    //8 characters are decoded to 6 bytes at once
+    while (end - it >= 8) {
+        quint64 bits = 0;
+        for (int i = 0; i < 8; i++) {
+            quint8 bitsValue = values[it[i]];
+            invalid |= bitsValue;
+            bits = (bits << 6) | bitsValue;
+        }
+        for (int i = 0; i < 6; i++) {
+            out[i] = static_cast<char>(bits >> (40 - i * 8));
+        }
+        out += 6;
+        it += 8;
+    }
+
+    //Rest of characters is padded with zero bits to 8 characters
+    if (it != end) {
+        int left = static_cast<int>(end - it);
+        quint64 bits = 0;
+        for (int i = 0; i < 8; i++) {
+            quint8 bitsValue = i < left ? values[it[i]] : 0;
+            invalid |= bitsValue;
+            bits = (bits << 6) | bitsValue;
+        }
+        int bytes = left * 6 / 8;
+        for (int i = 0; i < bytes; i++) {
+            out[i] = static_cast<char>(bits >> (40 - i * 8));
+        }
+        out += bytes;
+    }
+
+    if ((invalid & 0x80) != 0) {
+        return false;
+    }
+    Q_ASSERT(out == result.constData() + result.size());
+    value = result;
+    return true;
+}
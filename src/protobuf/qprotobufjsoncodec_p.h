@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufJsonCodec
+
+#include <QByteArray>
+#include <QString>
+
+namespace QtProtobuf {
+
+/*!
+ * \private
+ * \brief The QProtobufJsonCodec class encodes and decodes json string and bytes values
+ *
+ * \details Results are written to output directly, without intermediate buffers. Runs of plain ASCII
+ *          characters are processed by machine words.
+ */
+class QProtobufJsonCodec final
+{
+public:
+    /*!
+     * \brief Appends \a value to \a out as quoted json string in UTF-8, characters are escaped if required
+     */
+    static void writeString(const QString &value, QByteArray &out);
+
+    /*!
+     * \brief Reads json string \a data without quotation marks to \a value
+     *
+     * \details Escape sequences are resolved, invalid escape sequences are replaced with U+FFFD.
+     *          Returns false if \a data is not valid UTF-8.
+     */
+    static bool readString(const char *data, int size, QString &value);
+
+    /*!
+     * \brief Appends base64 representation of \a data to \a out with padding
+     */
+    static void writeBase64(const char *data, int size, QByteArray &out);
+
+    /*!
+     * \brief Reads base64 \a data to \a value
+     *
+     * \details Both standard and URL-safe alphabets are accepted, padding is optional.
+     *          Returns false if \a data contains characters out of alphabet.
+     */
+    static bool readBase64(const char *data, int size, QByteArray &value);
+};
+
+}
@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufjsonlines.h"
+
+#include <cstring>
+
+using namespace QtProtobuf;
+
+namespace {
+const int ReadChunkSize = 64 * 1024;
+}
+
+QProtobufJsonLinesWriter::QProtobufJsonLinesWriter(QProtobufJsonSerializer *serializer, QIODevice *device) :
+    m_serializer(serializer)
+  , m_device(device)
+  , m_count(0)
+{
+    Q_ASSERT(serializer != nullptr && device != nullptr);
+}
+
+bool QProtobufJsonLinesWriter::writeLine(QByteArray line)
+{
+    line.append('\n');
+    if (m_device->write(line) != line.size()) {
+        return false;
+    }
+    ++m_count;
+    return true;
+}
+
+QProtobufJsonLinesReader::QProtobufJsonLinesReader(QProtobufJsonSerializer *serializer, QIODevice *device) :
+    m_serializer(serializer)
+  , m_device(device)
+  , m_position(0)
+  , m_scanned(0)
+  , m_finished(false)
+{
+    Q_ASSERT(serializer != nullptr);
+}
+
+void QProtobufJsonLinesReader::feed(const QByteArray &chunk)
+{
+    append(chunk);
+}
+
+void QProtobufJsonLinesReader::append(const QByteArray &chunk)
+{
+    //Lines that are already read are dropped before buffer grows, so only incomplete line is moved
+    if (m_position > 0) {
+        m_buffer.remove(0, m_position);
+        m_scanned -= m_position;
+        m_position = 0;
+    }
+    m_buffer.append(chunk);
+}
+
+bool QProtobufJsonLinesReader::readDevice()
+{
+    if (m_device == nullptr) {
+        return false;
+    }
+
+    QByteArray chunk = m_device->read(ReadChunkSize);
+    if (chunk.isEmpty()) {
+        if (!m_device->isSequential() && m_device->atEnd()) {
+            m_finished = true;
+        }
+        return false;
+    }
+    append(chunk);
+    return true;
+}
+
+bool QProtobufJsonLinesReader::nextLine(QByteArray &line)
+{
+    for (;;) {
+        const char *data = m_buffer.constData();
+        const int size = m_buffer.size();
+        const char *found = static_cast<const char *>(memchr(data + m_scanned, '\n', size - m_scanned));
+        int end = found != nullptr ? int(found - data) : size;
+        if (found == nullptr) {
+            m_scanned = size;
+            if (readDevice()) {
+                continue;
+            }
+            if (!m_finished || pendingSize() == 0) {
+                return false;
+            }
+        }
+
+        const int begin = m_position;
+        m_position = qMin(end + 1, size);
+        m_scanned = m_position;
+        if (end > begin && data[end - 1] == '\r') {
+            --end;
+        }
+        if (end == begin) {
+            continue;
+        }
+
+        //Line refers reader buffer, it's valid until next chunk is appended
+        line = QByteArray::fromRawData(data + begin, end - begin);
+        return true;
+    }
+}
@@ -0,0 +1,178 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufJsonLinesWriter, QProtobufJsonLinesReader
+
+#include "qtprotobufglobal.h"
+#include "qprotobufjsonserializer.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QSharedPointer>
+
+namespace QtProtobuf {
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufJsonLinesWriter class writes messages to device in newline-delimited json format
+ *
+ * \details Each message is written to \a device as soon as it's serialized, as single line of json
+ *          terminated by '\n'. Serialized json never contains raw line breaks, since they are escaped
+ *          in strings, so lines may be consumed by any NDJSON reader.
+ *
+ * \code
+ * QFile file("records.ndjson");
+ * file.open(QIODevice::WriteOnly);
+ * QProtobufJsonLinesWriter writer(serializer, &file);
+ * for (const auto &record : records) {
+ *     writer.write(record.data());
+ * }
+ * \endcode
+ */
+class Q_PROTOBUF_EXPORT QProtobufJsonLinesWriter
+{
+public:
+    QProtobufJsonLinesWriter(QProtobufJsonSerializer *serializer, QIODevice *device);
+
+    /*!
+     * \brief Writes \a object as next line
+     * \return true if line is written to device completely
+     */
+    template<typename T>
+    bool write(const T *object) {
+        Q_ASSERT(object != nullptr);
+        return writeLine(m_serializer->serialize<T>(object));
+    }
+
+    /*!
+     * \brief Writes each of \a objects as separate line
+     * \return true if all lines are written to device completely
+     */
+    template<typename T>
+    bool write(const QList<QSharedPointer<T>> &objects) {
+        for (const auto &object : objects) {
+            if (!write(object.data())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Returns number of lines written so far
+     */
+    qint64 count() const { return m_count; }
+
+private:
+    Q_DISABLE_COPY(QProtobufJsonLinesWriter)
+    bool writeLine(QByteArray line);
+
+    QProtobufJsonSerializer *m_serializer;
+    QIODevice *m_device;
+    qint64 m_count;
+};
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufJsonLinesReader class reads messages of newline-delimited json stream one by one
+ *
+ * \details Data is either read from device that reader is constructed with, by chunks of bounded size
+ *          as soon as more data is required, or fed using feed(). Only incomplete line is kept between
+ *          calls, so memory usage doesn't depend on size of stream. Empty lines are skipped, "\r\n" line
+ *          endings are accepted. Last line that is not terminated by '\n' is read when end of device is
+ *          reached or finish() is called.
+ *
+ * \code
+ * QProtobufJsonLinesReader reader(serializer, &file);
+ * SimpleMessage message;
+ * QProtobufJsonLinesReader::ReadResult result;
+ * while ((result = reader.read(&message)) != QProtobufJsonLinesReader::NoMessage) {
+ *     if (result == QProtobufJsonLinesReader::MessageRead) {
+ *         process(message);
+ *     }
+ * }
+ * \endcode
+ */
+class Q_PROTOBUF_EXPORT QProtobufJsonLinesReader
+{
+public:
+    /*!
+     * \brief The ReadResult enum describes result of read()
+     */
+    enum ReadResult {
+        NoMessage = 0, /*!< No complete line is available yet or end of stream is reached */
+        MessageRead, /*!< Next message is read */
+        MalformedMessage /*!< Next line is not valid message, line is skipped. Reason is available using
+                              QProtobufJsonSerializer::deserializationError() */
+    };
+
+    QProtobufJsonLinesReader(QProtobufJsonSerializer *serializer, QIODevice *device = nullptr);
+
+    /*!
+     * \brief Reads next message to \a object
+     *
+     * \details If line is malformed, \a object keeps fields that were read before failure
+     */
+    template<typename T>
+    ReadResult read(T *object) {
+        Q_ASSERT(object != nullptr);
+        QByteArray line;
+        if (!nextLine(line)) {
+            return NoMessage;
+        }
+        return m_serializer->tryDeserialize(object, line) ? MessageRead : MalformedMessage;
+    }
+
+    /*!
+     * \brief Appends \a chunk to stream, chunks may be split at any byte
+     */
+    void feed(const QByteArray &chunk);
+
+    /*!
+     * \brief Marks end of stream, so last line is read even if it's not terminated by '\n'
+     */
+    void finish() { m_finished = true; }
+
+    /*!
+     * \brief Returns number of bytes that are kept until line is complete
+     */
+    int pendingSize() const { return m_buffer.size() - m_position; }
+
+private:
+    Q_DISABLE_COPY(QProtobufJsonLinesReader)
+    bool nextLine(QByteArray &line);
+    bool readDevice();
+    void append(const QByteArray &chunk);
+
+    QProtobufJsonSerializer *m_serializer;
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_position;//Beginning of first line that is not read yet
+    int m_scanned;//Bytes of buffer that are known not to contain line end
+    bool m_finished;
+};
+
+}
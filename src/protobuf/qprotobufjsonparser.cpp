@@ -0,0 +1,236 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufjsonparser_p.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace QtProtobuf;
+
+namespace {
+constexpr quint64 Ones = 0x0101010101010101ULL;
+constexpr quint64 HighBits = 0x8080808080808080ULL;
+
+//Returns non-zero if any byte of word is equal to c
+inline quint64 matchByte(quint64 word, unsigned char c)
+{
+    quint64 x = word ^ (Ones * c);
+    return (x - Ones) & ~x & HighBits;
+}
+
+//Checks 8 bytes at once if any of them is quotation mark, reverse solidus or structural character
+inline bool hasStructural(quint64 word)
+{
+    //Square brackets differ from curly brackets by 0x20 bit only, so both are matched at once.
+    //Reverse solidus is matched as '|' same way.
+    quint64 folded = word | (Ones * 0x20);
+    return (matchByte(word, '"') | matchByte(word, ':') | matchByte(word, ',')
+            | matchByte(folded, '{') | matchByte(folded, '}') | matchByte(folded, '|')) != 0;
+}
+
+//Checks 8 bytes at once if any of them is quotation mark or reverse solidus
+inline bool hasStringDelimiter(quint64 word)
+{
+    return (matchByte(word, '"') | matchByte(word, '\\')) != 0;
+}
+
+inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+}
+
+QProtobufJsonParser::QProtobufJsonParser(const char *data, int size) : m_data(data)
+  , m_size(size)
+  , m_valid(true)
+{
+    std::vector<int> openBrackets;
+    int stringBegin = -1;//Index of opening quotation mark of string that is scanned at the moment
+    int i = 0;
+    while (i < size) {
+        //Runs of bytes without characters of interest are skipped by 8 bytes
+        if (size - i >= 8) {
+            quint64 word;
+            memcpy(&word, data + i, sizeof(word));
+            if (stringBegin >= 0 ? !hasStringDelimiter(word) : !hasStructural(word)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        char c = data[i];
+        int index = static_cast<int>(m_tokens.size());
+        if (stringBegin >= 0) {
+            if (c == '\\') {
+                ++i;//Escaped character is skipped
+            } else if (c == '"') {
+                m_tokens[static_cast<size_t>(stringBegin)].pair = index;
+                m_tokens.push_back({i, stringBegin});
+                stringBegin = -1;
+            }
+        } else {
+            switch (c) {
+            case '"':
+                stringBegin = index;
+                m_tokens.push_back({i, -1});
+                break;
+            case '{':
+            case '[':
+                openBrackets.push_back(index);
+                m_tokens.push_back({i, -1});
+                break;
+            case '}':
+            case ']': {
+                char expected = c == '}' ? '{' : '[';
+                if (openBrackets.empty()
+                        || data[m_tokens[static_cast<size_t>(openBrackets.back())].position] != expected) {
+                    m_valid = false;
+                    return;
+                }
+                m_tokens[static_cast<size_t>(openBrackets.back())].pair = index;
+                m_tokens.push_back({i, openBrackets.back()});
+                openBrackets.pop_back();
+            }
+                break;
+            case ':':
+            case ',':
+                m_tokens.push_back({i, -1});
+                break;
+            default:
+                break;
+            }
+        }
+        ++i;
+    }
+    m_valid = openBrackets.empty() && stringBegin < 0;
+}
+
+bool QProtobufJsonParser::readValue(const char *position, Value &value, const char *&next) const
+{
+    const char *end = m_data + m_size;
+    if (!m_valid || position < m_data) {
+        return false;
+    }
+
+    while (position < end && isWhitespace(*position)) {
+        ++position;
+    }
+
+    if (position >= end) {
+        return false;
+    }
+
+    const char *valueEnd = nullptr;
+    switch (*position) {
+    case '}':
+    case ']':
+    case ',':
+    case ':':
+        return false;
+    case '"':
+    case '{':
+    case '[': {
+        int index = findToken(static_cast<int>(position - m_data));
+        if (index < 0 || m_tokens[static_cast<size_t>(index)].pair < 0) {
+            return false;
+        }
+        const char *pair = m_data + m_tokens[static_cast<size_t>(m_tokens[static_cast<size_t>(index)].pair)].position;
+        if (*position == '"') {
+            value = {position + 1, static_cast<int>(pair - position - 1), StringType};
+        } else {
+            value = {position, static_cast<int>(pair - position + 1), *position == '{' ? ObjectType : ArrayType};
+        }
+        valueEnd = pair + 1;
+    }
+        break;
+    default: {
+        //Scalar value lasts until next structural character
+        int offset = static_cast<int>(position - m_data);
+        auto token = std::upper_bound(m_tokens.begin(), m_tokens.end(), offset, [](int valuePosition, const Token &token) {
+            return valuePosition < token.position;
+        });
+        valueEnd = token != m_tokens.end() ? m_data + token->position : end;
+        const char *last = valueEnd;
+        while (last > position && isWhitespace(*(last - 1))) {
+            --last;
+        }
+
+        ValueType type = NumberType;
+        if (*position == 'n') {
+            type = NullType;
+        } else if (*position == 't' || *position == 'f') {
+            type = BoolType;
+        }
+        value = {position, static_cast<int>(last - position), type};
+    }
+        break;
+    }
+
+    next = skipSeparator(valueEnd);
+    return true;
+}
+
+bool QProtobufJsonParser::readMember(const char *position, Value &name, Value &value, const char *&next) const
+{
+    const char *separator = nullptr;
+    if (!readValue(position, name, separator) || name.type != StringType
+            || separator >= m_data + m_size || *separator != ':') {
+        return false;
+    }
+    return readValue(separator + 1, value, next);
+}
+
+int QProtobufJsonParser::findToken(int position) const
+{
+    auto token = std::lower_bound(m_tokens.begin(), m_tokens.end(), position, [](const Token &token, int tokenPosition) {
+        return token.position < tokenPosition;
+    });
+    if (token == m_tokens.end() || token->position != position) {
+        return -1;
+    }
+    return static_cast<int>(token - m_tokens.begin());
+}
+
+//Checks if only whitespaces are left before closing bracket at end - 1
+bool QProtobufJsonParser::isClosingBracket(const char *position, const char *end) const
+{
+    while (position < end && isWhitespace(*position)) {
+        ++position;
+    }
+    return position == end - 1;
+}
+
+const char *QProtobufJsonParser::skipSeparator(const char *position) const
+{
+    const char *end = m_data + m_size;
+    while (position < end && isWhitespace(*position)) {
+        ++position;
+    }
+    if (position < end && (*position == ',' || *position == '}' || *position == ']')) {
+        ++position;
+    }
+    return position;
+}
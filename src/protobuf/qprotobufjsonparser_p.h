@@ -0,0 +1,163 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufJsonParser
+
+#include <QByteArray>
+
+#include <vector>
+
+namespace QtProtobuf {
+
+/*!
+ * \private
+ * \brief The QProtobufJsonParser class provides in place access to values of json document
+ *
+ * \details Document is scanned once, when parser is constructed: positions of structural characters
+ *          outside of strings and bounds of strings are collected to index, each bracket and quotation
+ *          mark is linked to its pair. Values are returned as spans of source buffer, so nested objects
+ *          and arrays are skipped using index and never scanned again. Parser doesn't copy the source
+ *          buffer, it must outlive parser and all values returned by it.
+ */
+class QProtobufJsonParser final
+{
+public:
+    enum ValueType {
+        InvalidType = 0,
+        NullType,
+        BoolType,
+        NumberType,
+        StringType,
+        ObjectType,
+        ArrayType
+    };
+
+    /*!
+     * \brief Span of json value in source buffer. Strings are without quotation marks and escape sequences
+     *        are not resolved, objects and arrays include brackets.
+     */
+    struct Value {
+        const char *data = nullptr;
+        int size = 0;
+        ValueType type = InvalidType;
+
+        /*!
+         * \brief Returns value bytes that refer source buffer without copying
+         */
+        QByteArray bytes() const {
+            return QByteArray::fromRawData(data, size);
+        }
+    };
+
+    QProtobufJsonParser(const char *data, int size);
+
+    /*!
+     * \brief Returns false if brackets or quotation marks in document are unbalanced
+     */
+    bool isValid() const {
+        return m_valid;
+    }
+
+    /*!
+     * \brief Returns true if \a data points to byte of indexed document
+     */
+    bool contains(const char *data) const {
+        return data >= m_data && data < m_data + m_size;
+    }
+
+    /*!
+     * \brief Reads value that starts at \a position, leading whitespaces are skipped
+     *
+     * \details \a next is set after separator or closing bracket that follows value. Returns false if
+     *          there is no value at \a position, e.g. closing bracket of empty array is reached.
+     */
+    bool readValue(const char *position, Value &value, const char *&next) const;
+
+    /*!
+     * \brief Reads object member "name":value that starts at \a position, leading whitespaces are skipped
+     *
+     * \details \a next is set same way as by readValue().
+     */
+    bool readMember(const char *position, Value &name, Value &value, const char *&next) const;
+
+    /*!
+     * \brief Calls \a f for each name and value of \a object members
+     *
+     * \return false if \a object is not an object or one of its members is malformed, e.g. value is missing
+     */
+    template<typename F>
+    bool forEachMember(const Value &object, F f) const {
+        if (object.type != ObjectType) {
+            return false;
+        }
+        const char *position = object.data + 1;
+        const char *end = object.data + object.size;
+        Value name;
+        Value value;
+        bool empty = true;
+        while (position < end) {
+            if (!readMember(position, name, value, position)) {
+                //Only closing bracket of empty object is not a member
+                return empty && isClosingBracket(position, end);
+            }
+            f(name, value);
+            empty = false;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Calls \a f for each element of \a array
+     */
+    template<typename F>
+    void forEachElement(const Value &array, F f) const {
+        if (array.type != ArrayType) {
+            return;
+        }
+        const char *position = array.data + 1;
+        const char *end = array.data + array.size;
+        Value value;
+        while (position < end && readValue(position, value, position)) {
+            f(value);
+        }
+    }
+
+private:
+    struct Token {
+        int position;
+        int pair;//Index of paired bracket or quotation mark, -1 for separators
+    };
+
+    int findToken(int position) const;
+    bool isClosingBracket(const char *position, const char *end) const;
+    const char *skipSeparator(const char *position) const;
+
+    const char *m_data;
+    int m_size;
+    std::vector<Token> m_tokens;
+    bool m_valid;
+};
+
+}
@@ -24,13 +24,19 @@
  */
 
 #include "qprotobufjsonserializer.h"
+#include "qprotobufjsoncodec_p.h"
+#include "qprotobufjsonparser_p.h"
 #include "qprotobufmetaobject.h"
 #include "qprotobufmetaproperty.h"
 #include "qtprotobuflogging.h"
 
-#include <microjson.h>
-
 #include <QMetaProperty>
+#include <QLocale>
+#include <QScopedValueRollback>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace QtProtobuf;
 
@@ -41,8 +47,8 @@ class QProtobufJsonSerializerPrivate final
 {
     Q_DISABLE_COPY_MOVE(QProtobufJsonSerializerPrivate)
 public:
-    using Serializer = std::function<QByteArray(const QVariant&)>;
-    using Deserializer = std::function<QVariant(QByteArray, microjson::JsonType, bool &)>;
+    using Serializer = std::function<void(const QVariant &, QByteArray &)>;
+    using Deserializer = std::function<QVariant(const QByteArray &, QProtobufJsonParser::ValueType, bool &)>;
 
     struct SerializationHandlers {
         Serializer serializer; /*!< serializer assigned to class */
@@ -51,197 +57,300 @@ public:
 
     using SerializerRegistry = std::unordered_map<int/*metatypeid*/, SerializationHandlers>;
 
-    static QByteArray serializeFloat(const QVariant &propertyValue) {
-        bool ok = false;
-        float value = propertyValue.toFloat(&ok);
-        if (!ok) {
-            return QByteArray("NaN");
+    //---------------------Values are written directly to output---------------------
+    static void writeInteger(qint64 value, QByteArray &out) {
+        quint64 magnitude = value < 0 ? 0 - static_cast<quint64>(value) : static_cast<quint64>(value);
+        char buffer[24];
+        char *end = buffer + sizeof(buffer);
+        char *it = writeDigits(magnitude, end);
+        if (value < 0) {
+            *--it = '-';
         }
-        return QString::number(static_cast<double>(value), 'g').toUtf8();
+        out.append(it, static_cast<int>(end - it));
     }
 
-    static QByteArray serializeString(const QVariant &propertyValue) {
-        return QString("\"%1\"").arg(propertyValue.toString()).toUtf8() ;
+    static void writeInteger(quint64 value, QByteArray &out) {
+        char buffer[24];
+        char *end = buffer + sizeof(buffer);
+        char *it = writeDigits(value, end);
+        out.append(it, static_cast<int>(end - it));
     }
 
-    static QByteArray serializeBytes(const QVariant &propertyValue) {
-        return QByteArray("\"") + propertyValue.toByteArray().toBase64() + "\"";
+    static char *writeDigits(quint64 value, char *end) {
+        do {
+            *--end = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return end;
     }
 
-    template<typename L>
-    static QByteArray serializeList(const QVariant &propertyValue) {
-        L listValue = propertyValue.value<L>();
-        QByteArray result("[");
-        for (auto value : listValue) {
-            result += QString::number(value).toUtf8() + ",";
-        }
-        if (listValue.size() > 0) {
-            result.resize(result.size() - 1);//Remove trailing `,`
-        }
-        result += "]";
-        return result;
+    template<typename T,
+             typename std::enable_if_t<std::is_signed<T>::value, int> = 0>
+    static void writeValue(const T &value, QByteArray &out) {
+        writeInteger(static_cast<qint64>(value), out);
     }
 
-    static QByteArray serializeDoubleList(const QVariant &propertyValue) {
-        DoubleList listValue = propertyValue.value<DoubleList>();
-        QByteArray result("[");
-        for (auto value : listValue) {
-            result += QString::number(value, 'g').toUtf8() + ",";
-        }
-        if (listValue.size() > 0) {
-            result.resize(result.size() - 1);//Remove trailing `,`
-        }
-        result += "]";
-        return result;
+    template<typename T,
+             typename std::enable_if_t<!std::is_signed<T>::value, int> = 0>
+    static void writeValue(const T &value, QByteArray &out) {
+        writeInteger(static_cast<quint64>(value), out);
+    }
+
+    static void writeValue(bool value, QByteArray &out) {
+        out.append(value ? "true" : "false");
     }
 
-    static QByteArray serializeStringList(const QVariant &propertyValue) {
-        QStringList listValue = propertyValue.value<QStringList>();
-        QByteArray result("[");
-        for (auto value : listValue) {
-            result += QByteArray("\"") + value.toUtf8() + "\",";
+    static bool writeSpecialValue(double value, QByteArray &out) {
+        if (qIsNaN(value)) {
+            out.append("\"NaN\"");
+        } else if (qIsInf(value)) {
+            out.append(value > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+        } else if (value == 0) {
+            out.append('0');//Also for negative zero
+        } else {
+            return false;
         }
-        if (listValue.size() > 0) {
-            result.resize(result.size() - 1);//Remove trailing `,`
+        return true;
+    }
+
+    //Shortest representation that is parsed back to same value
+    static void writeValue(double value, QByteArray &out) {
+        if (!writeSpecialValue(value, out)) {
+            out.append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
         }
-        result += "]";
-        return result;
     }
 
-    static QByteArray serializeBytesList(const QVariant &propertyValue) {
-        QByteArrayList listValue = propertyValue.value<QByteArrayList>();
-        QByteArray result("[");
-        for (auto value : listValue) {
-            result += QByteArray("\"") + value.toBase64() + "\",";
+    static void writeValue(float value, QByteArray &out) {
+        if (writeSpecialValue(static_cast<double>(value), out)) {
+            return;
         }
-        if (listValue.size() > 0) {
-            result.resize(result.size() - 1);//Remove trailing `,`
+        //9 significant digits are always enough to restore float value. Candidates are formatted to stack
+        //buffer, formatting and parsing use same C locale, so check is consistent
+        char buffer[32];
+        int size = 0;
+        for (int precision = 6; precision <= 9; precision++) {
+            size = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, static_cast<double>(value));
+            if (std::strtof(buffer, nullptr) == value) {
+                break;
+            }
         }
-        result += "]";
-        return result;
+
+        //Decimal separator of C locale is replaced with JSON one
+        for (int i = 0; i < size; i++) {
+            char c = buffer[i];
+            if ((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e') {
+                buffer[i] = '.';
+            }
+        }
+        out.append(buffer, size);
+    }
+
+    static void writeValue(const QString &value, QByteArray &out) {
+        QProtobufJsonCodec::writeString(value, out);
+    }
+
+    static void writeValue(const QByteArray &value, QByteArray &out) {
+        out.append('"');
+        QProtobufJsonCodec::writeBase64(value.constData(), value.size(), out);
+        out.append('"');
+    }
+
+    template<typename T>
+    static void serializeBasic(const QVariant &propertyValue, QByteArray &out) {
+        writeValue(propertyValue.value<T>(), out);
     }
 
-    QProtobufJsonSerializerPrivate(QProtobufJsonSerializer *q) : qPtr(q) {
-        if (handlers.empty()) {
-            handlers[qMetaTypeId<QtProtobuf::int32>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt32};
-            handlers[qMetaTypeId<QtProtobuf::sfixed32>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt32};
-            handlers[qMetaTypeId<QtProtobuf::sint32>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt32};
-            handlers[qMetaTypeId<QtProtobuf::sint64>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt64};
-            handlers[qMetaTypeId<QtProtobuf::int64>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt64};
-            handlers[qMetaTypeId<QtProtobuf::sfixed64>()] = {{}, QProtobufJsonSerializerPrivate::deserializeInt64};
-            handlers[qMetaTypeId<QtProtobuf::uint32>()] = {{}, QProtobufJsonSerializerPrivate::deserializeUInt32};
-            handlers[qMetaTypeId<QtProtobuf::fixed32>()] = {{}, QProtobufJsonSerializerPrivate::deserializeUInt32};
-            handlers[qMetaTypeId<QtProtobuf::uint64>()] = {{}, QProtobufJsonSerializerPrivate::deserializeUInt64};
-            handlers[qMetaTypeId<QtProtobuf::fixed64>()] = {{}, QProtobufJsonSerializerPrivate::deserializeUInt64};
-            handlers[qMetaTypeId<bool>()] = {{}, QProtobufJsonSerializerPrivate::deserializeBool};
-            handlers[QMetaType::Float] = {QProtobufJsonSerializerPrivate::serializeFloat, QProtobufJsonSerializerPrivate::deserializeFloat};
-            handlers[QMetaType::Double] = {{}, QProtobufJsonSerializerPrivate::deserializeDouble};
-            handlers[QMetaType::QString] = {QProtobufJsonSerializerPrivate::serializeString, QProtobufJsonSerializerPrivate::deserializeString};
-            handlers[QMetaType::QByteArray] = {QProtobufJsonSerializerPrivate::serializeBytes, QProtobufJsonSerializerPrivate::deserializeByteArray};
-            handlers[qMetaTypeId<QtProtobuf::int32List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::int32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::int32>};
-            handlers[qMetaTypeId<QtProtobuf::int64List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::int64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::int64>};
-            handlers[qMetaTypeId<QtProtobuf::sint32List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::sint32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sint32>};
-            handlers[qMetaTypeId<QtProtobuf::sint64List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::sint64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sint64>};
-            handlers[qMetaTypeId<QtProtobuf::uint32List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::uint32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::uint32>};
-            handlers[qMetaTypeId<QtProtobuf::uint64List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::uint64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::uint64>};
-            handlers[qMetaTypeId<QtProtobuf::fixed32List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::fixed32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::fixed32>};
-            handlers[qMetaTypeId<QtProtobuf::fixed64List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::fixed64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::fixed64>};
-            handlers[qMetaTypeId<QtProtobuf::sfixed32List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::sfixed32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sfixed32>};
-            handlers[qMetaTypeId<QtProtobuf::sfixed64List>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::sfixed64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sfixed64>};
-            handlers[qMetaTypeId<QtProtobuf::FloatList>()] = {QProtobufJsonSerializerPrivate::serializeList<QtProtobuf::FloatList>, QProtobufJsonSerializerPrivate::deserializeList<float>};
-            handlers[qMetaTypeId<QtProtobuf::DoubleList>()] = {QProtobufJsonSerializerPrivate::serializeDoubleList, QProtobufJsonSerializerPrivate::deserializeList<double>};
-            handlers[qMetaTypeId<QStringList>()] = {QProtobufJsonSerializerPrivate::serializeStringList, QProtobufJsonSerializerPrivate::deserializeStringList};
-            handlers[qMetaTypeId<QByteArrayList>()] = {QProtobufJsonSerializerPrivate::serializeBytesList, QProtobufJsonSerializerPrivate::deserializeList<QByteArray>};
+    template<typename L>
+    static void serializeList(const QVariant &propertyValue, QByteArray &out) {
+        L listValue = propertyValue.value<L>();
+        out.append('[');
+        for (int i = 0; i < listValue.size(); i++) {
+            if (i > 0) {
+                out.append(',');
+            }
+            writeValue(listValue.at(i), out);
         }
+        out.append(']');
     }
+
+    QProtobufJsonSerializerPrivate(QProtobufJsonSerializer *q) : qPtr(q), sizeEstimate(0) {}
     ~QProtobufJsonSerializerPrivate() = default;
 
-    QByteArray serializeValue(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty) {
-        QByteArray buffer;
+    //Registry is initialized once in thread-safe way, afterwards it's read only
+    static const SerializerRegistry &handlers() {
+        static const SerializerRegistry registry = [] {
+            SerializerRegistry result;
+            result[qMetaTypeId<QtProtobuf::int32>()] = {serializeBasic<QtProtobuf::int32>, QProtobufJsonSerializerPrivate::deserializeInt32};
+            result[qMetaTypeId<QtProtobuf::sfixed32>()] = {serializeBasic<QtProtobuf::sfixed32>, QProtobufJsonSerializerPrivate::deserializeInt32};
+            result[qMetaTypeId<QtProtobuf::sint32>()] = {serializeBasic<QtProtobuf::sint32>, QProtobufJsonSerializerPrivate::deserializeInt32};
+            result[qMetaTypeId<QtProtobuf::sint64>()] = {serializeBasic<QtProtobuf::sint64>, QProtobufJsonSerializerPrivate::deserializeInt64};
+            result[qMetaTypeId<QtProtobuf::int64>()] = {serializeBasic<QtProtobuf::int64>, QProtobufJsonSerializerPrivate::deserializeInt64};
+            result[qMetaTypeId<QtProtobuf::sfixed64>()] = {serializeBasic<QtProtobuf::sfixed64>, QProtobufJsonSerializerPrivate::deserializeInt64};
+            result[qMetaTypeId<QtProtobuf::uint32>()] = {serializeBasic<QtProtobuf::uint32>, QProtobufJsonSerializerPrivate::deserializeUInt32};
+            result[qMetaTypeId<QtProtobuf::fixed32>()] = {serializeBasic<QtProtobuf::fixed32>, QProtobufJsonSerializerPrivate::deserializeUInt32};
+            result[qMetaTypeId<QtProtobuf::uint64>()] = {serializeBasic<QtProtobuf::uint64>, QProtobufJsonSerializerPrivate::deserializeUInt64};
+            result[qMetaTypeId<QtProtobuf::fixed64>()] = {serializeBasic<QtProtobuf::fixed64>, QProtobufJsonSerializerPrivate::deserializeUInt64};
+            result[qMetaTypeId<bool>()] = {serializeBasic<bool>, QProtobufJsonSerializerPrivate::deserializeBool};
+            result[QMetaType::Float] = {serializeBasic<float>, QProtobufJsonSerializerPrivate::deserializeFloat};
+            result[QMetaType::Double] = {serializeBasic<double>, QProtobufJsonSerializerPrivate::deserializeDouble};
+            result[QMetaType::QString] = {serializeBasic<QString>, QProtobufJsonSerializerPrivate::deserializeString};
+            result[QMetaType::QByteArray] = {serializeBasic<QByteArray>, QProtobufJsonSerializerPrivate::deserializeByteArray};
+            result[qMetaTypeId<QtProtobuf::int32List>()] = {serializeList<QtProtobuf::int32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::int32>};
+            result[qMetaTypeId<QtProtobuf::int64List>()] = {serializeList<QtProtobuf::int64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::int64>};
+            result[qMetaTypeId<QtProtobuf::sint32List>()] = {serializeList<QtProtobuf::sint32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sint32>};
+            result[qMetaTypeId<QtProtobuf::sint64List>()] = {serializeList<QtProtobuf::sint64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sint64>};
+            result[qMetaTypeId<QtProtobuf::uint32List>()] = {serializeList<QtProtobuf::uint32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::uint32>};
+            result[qMetaTypeId<QtProtobuf::uint64List>()] = {serializeList<QtProtobuf::uint64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::uint64>};
+            result[qMetaTypeId<QtProtobuf::fixed32List>()] = {serializeList<QtProtobuf::fixed32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::fixed32>};
+            result[qMetaTypeId<QtProtobuf::fixed64List>()] = {serializeList<QtProtobuf::fixed64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::fixed64>};
+            result[qMetaTypeId<QtProtobuf::sfixed32List>()] = {serializeList<QtProtobuf::sfixed32List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sfixed32>};
+            result[qMetaTypeId<QtProtobuf::sfixed64List>()] = {serializeList<QtProtobuf::sfixed64List>, QProtobufJsonSerializerPrivate::deserializeList<QtProtobuf::sfixed64>};
+            result[qMetaTypeId<QtProtobuf::FloatList>()] = {serializeList<QtProtobuf::FloatList>, QProtobufJsonSerializerPrivate::deserializeList<float>};
+            result[qMetaTypeId<QtProtobuf::DoubleList>()] = {serializeList<QtProtobuf::DoubleList>, QProtobufJsonSerializerPrivate::deserializeList<double>};
+            result[qMetaTypeId<QStringList>()] = {serializeList<QStringList>, QProtobufJsonSerializerPrivate::deserializeStringList};
+            result[qMetaTypeId<QByteArrayList>()] = {serializeList<QByteArrayList>, QProtobufJsonSerializerPrivate::deserializeList<QByteArray>};
+            return result;
+        }();
+        return registry;
+    }
+
+    /*!
+     * \brief Calls \a writer with output buffer. If message is serialized at the moment, nested values are
+     *        written to its output directly and empty array is returned, otherwise result is returned.
+     */
+    template<typename F>
+    static QByteArray write(F writer) {
+        if (output != nullptr) {
+            writer(*output);
+            return QByteArray();
+        }
+        QByteArray result;
+        QScopedValueRollback<QByteArray *> scope(output, &result);
+        writer(result);
+        return result;
+    }
+
+    void writeValue(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty, QByteArray &out) {
         auto userType = propertyValue.userType();
         auto value = QtProtobufPrivate::findHandler(userType);
-        if (value.serializer) {
-            value.serializer(qPtr, propertyValue, metaProperty, buffer);
+        if (value != nullptr) {
+            //Handlers call virtual methods of serializer that write to same output
+            Q_ASSERT(output == &out);
+            value->serializer(qPtr, propertyValue, metaProperty, out);
         } else {
-            auto handler = handlers.find(userType);
-            if (handler != handlers.end() && handler->second.serializer) {
-                buffer += handler->second.serializer(propertyValue);
+            auto handler = handlers().find(userType);
+            if (handler != handlers().end() && handler->second.serializer) {
+                handler->second.serializer(propertyValue, out);
             } else {
-                buffer += propertyValue.toString().toUtf8();
+                out.append(propertyValue.toString().toUtf8());
             }
         }
-        return buffer;
     }
 
-    QByteArray serializeProperty(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty) {
-        return QByteArray("\"") + metaProperty.jsonPropertyName().toUtf8() + "\":" + serializeValue(propertyValue, metaProperty);
-    }
+    void writeObject(const QObject *object, const QProtobufMetaObject &metaObject, QByteArray &out) {
+        out.append('{');
+        bool first = true;
+        for (const auto &field : metaObject.fields()) {
+            if (!first) {
+                out.append(',');
+            }
+            first = false;
+            out.append(field.jsonKey);
+            writeValue(field.metaProperty.read(object), field.metaProperty, out);
+        }
+        out.append('}');
+    }
+
+    QByteArray serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) {
+        //Output is reserved for decaying average size of previous messages, so series of similar messages
+        //are written without reallocations, while single big message doesn't inflate following ones
+        QByteArray result;
+        int estimate = sizeEstimate.load(std::memory_order_relaxed);
+        int reserved = estimate;
+        if (reserved < MinReservedSize) {
+            reserved = MinReservedSize;
+        } else if (reserved > MaxReservedSize) {
+            reserved = MaxReservedSize;
+        }
+        result.reserve(reserved);
+        QScopedValueRollback<QByteArray *> scope(output, &result);
+        writeObject(object, metaObject, result);
+
+        int size = result.size();
+        sizeEstimate.store(estimate + (size - estimate) / 4, std::memory_order_relaxed);
 
-    QByteArray serializeObject(const QObject *object, const QProtobufMetaObject &metaObject) {
-        QByteArray result = "{";
-        for (const auto &field : metaObject.propertyOrdering) {
-            int propertyIndex = field.second;
-            int fieldIndex = field.first;
-            Q_ASSERT_X(fieldIndex < 536870912 && fieldIndex > 0, "", "fieldIndex is out of range");
-            QMetaProperty metaProperty = metaObject.staticMetaObject.property(propertyIndex);
-            const char *propertyName = metaProperty.name();
-            const QVariant &propertyValue = object->property(propertyName);
-            result.append(serializeProperty(propertyValue, QProtobufMetaProperty(metaProperty,
-                                                                                 fieldIndex,
-                                                                                 field.second)));
-            result.append(",");
+        //Result doesn't keep capacity that is far above its size
+        if (result.capacity() - size > MinReservedSize && result.capacity() > 2 * size) {
+            result.squeeze();
         }
-        result.resize(result.size() - 1);//Remove trailing `,`
-        result.append("}");
         return result;
     }
 
-    static QVariant deserializeInt32(const QByteArray &data, microjson::JsonType type, bool &ok) {
+    static QVariant deserializeInt32(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
         auto val = data.toInt(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeUInt32(const QByteArray &data, microjson::JsonType type, bool &ok) {
+    static QVariant deserializeUInt32(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
         auto val = data.toUInt(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeInt64(const QByteArray &data, microjson::JsonType type, bool &ok) {
+    static QVariant deserializeInt64(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
         auto val = data.toLongLong(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeUInt64(const QByteArray &data, microjson::JsonType type, bool &ok) {
+    static QVariant deserializeUInt64(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
         auto val = data.toULongLong(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeFloat(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (data == "NaN" || data == "Infinity" || data == "-Infinity") {
+    //Reads values written by writeSpecialValue as strings
+    static bool readSpecialValue(const QByteArray &data, QProtobufJsonParser::ValueType type, double &value) {
+        if (type != QProtobufJsonParser::StringType) {
+            return false;
+        }
+        if (data == "NaN") {
+            value = qQNaN();
+        } else if (data == "Infinity") {
+            value = qInf();
+        } else if (data == "-Infinity") {
+            value = -qInf();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static QVariant deserializeFloat(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        double special = 0;
+        if (readSpecialValue(data, type, special)) {
             ok = true;
-            return QVariant();
+            return QVariant::fromValue(static_cast<float>(special));
         }
         auto val = data.toFloat(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeDouble(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (data == "NaN" || data == "Infinity" || data == "-Infinity") {
+    static QVariant deserializeDouble(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        double special = 0;
+        if (readSpecialValue(data, type, special)) {
             ok = true;
-            return QVariant();
+            return QVariant::fromValue(special);
         }
         auto val = data.toDouble(&ok);
-        ok |= type == microjson::JsonNumberType;
+        ok |= type == QProtobufJsonParser::NumberType;
         return QVariant::fromValue(val);
     }
 
-    static QVariant deserializeBool(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (type == microjson::JsonBoolType) {
+    static QVariant deserializeBool(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        if (type == QProtobufJsonParser::BoolType) {
             ok = true;
             return QVariant::fromValue(data == "true");
         }
@@ -250,120 +359,198 @@ public:
         return QVariant();
     }
 
-    static QVariant deserializeString(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (type == microjson::JsonStringType) {
-            ok = true;
-            return QVariant::fromValue(QString::fromUtf8(data).replace("\\\"", "\""));
-        }
-
-        ok = false;
-        return QVariant();
+    static QVariant deserializeString(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        QString value;
+        ok = type == QProtobufJsonParser::StringType
+                && QProtobufJsonCodec::readString(data.constData(), data.size(), value);
+        return ok ? QVariant::fromValue(value) : QVariant();
     }
 
-    static QVariant deserializeByteArray(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (type == microjson::JsonStringType) {
-            ok = true;
-            return QVariant::fromValue(QByteArray::fromBase64(data));
-        }
-
-        ok = false;
-        return QVariant();
+    static QVariant deserializeByteArray(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        QByteArray value;
+        ok = type == QProtobufJsonParser::StringType
+                && QProtobufJsonCodec::readBase64(data.constData(), data.size(), value);
+        return ok ? QVariant::fromValue(value) : QVariant();
     }
 
     template<typename T>
-    static QVariant deserializeList(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (type != microjson::JsonArrayType) {
+    static QVariant deserializeList(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        if (type != QProtobufJsonParser::ArrayType) {
             ok = false;
             return QVariant();
         }
 
         ok = true;
         QList<T> list;
-        auto arrayValues = microjson::parseJsonArray(data.data(), static_cast<size_t>(data.size()));
-        auto handler = handlers.find(qMetaTypeId<T>());
-        if (handler == handlers.end() || !handler->second.deserializer) {
+        auto handler = handlers().find(qMetaTypeId<T>());
+        if (handler == handlers().end() || !handler->second.deserializer) {
             qProtoWarning() << "Unable to deserialize simple type list. Could not find desrializer for type" << qMetaTypeId<T>();
             return QVariant::fromValue(list);
         }
 
-        for (auto &arrayValue : arrayValues) {
+        forEachElement(data, [&list, &handler](const QProtobufJsonParser::Value &arrayValue) {
             bool valueOk = false;
-            QVariant newValue = handler->second.deserializer(QByteArray::fromStdString(arrayValue.value), arrayValue.type, valueOk);
+            QVariant newValue = handler->second.deserializer(arrayValue.bytes(), arrayValue.type, valueOk);
             list.append(newValue.value<T>());
-        }
+        });
         return QVariant::fromValue(list);
     }
 
-    static QVariant deserializeStringList(const QByteArray &data, microjson::JsonType type, bool &ok) {
-        if (type != microjson::JsonArrayType) {
+    static QVariant deserializeStringList(const QByteArray &data, QProtobufJsonParser::ValueType type, bool &ok) {
+        if (type != QProtobufJsonParser::ArrayType) {
             ok = false;
             return QVariant();
         }
 
         ok = true;
         QStringList list;
-        auto arrayValues = microjson::parseJsonArray(data.data(), static_cast<size_t>(data.size()));
-        for (auto &arrayValue : arrayValues) {
+        forEachElement(data, [&list](const QProtobufJsonParser::Value &arrayValue) {
             bool valueOk = false;
-            QVariant newValue = deserializeString(QByteArray::fromStdString(arrayValue.value), arrayValue.type, valueOk);
+            QVariant newValue = deserializeString(arrayValue.bytes(), arrayValue.type, valueOk);
             list.append(newValue.value<QString>());
-        }
+        });
         return QVariant::fromValue(list);
     }
 
-    QVariant deserializeValue(int type, const QByteArray &data, microjson::JsonType jsonType, bool &ok) {
+    /*!
+     * \brief Calls \a f with parser of document that contains \a data. Nested values refer buffer of
+     *        document that is deserialized at the moment, so its index is reused and values are never
+     *        scanned twice.
+     */
+    template<typename F>
+    static void parse(const char *data, int size, F f) {
+        if (parser != nullptr && parser->contains(data)) {
+            f(*parser);
+            return;
+        }
+        QProtobufJsonParser localParser(data, size);
+        QScopedValueRollback<const QProtobufJsonParser *> scope(parser, &localParser);
+        f(localParser);
+    }
+
+    template<typename F>
+    static void forEachElement(const QByteArray &data, F f) {
+        parse(data.constData(), data.size(), [&data, &f](const QProtobufJsonParser &jsonParser) {
+            QProtobufJsonParser::Value array;
+            const char *next = nullptr;
+            if (jsonParser.readValue(data.constData(), array, next)) {
+                jsonParser.forEachElement(array, f);
+            }
+        });
+    }
+
+    QVariant deserializeValue(int type, const QProtobufJsonParser::Value &value, bool &ok) {
         QVariant newValue;
+        //Value bytes refer source buffer, so nested messages are deserialized in place
+        const QByteArray data = value.bytes();
         auto handler = QtProtobufPrivate::findHandler(type);
-        if (handler.deserializer) {
+        if (handler != nullptr) {
             QtProtobuf::QProtobufSelfcheckIterator it(data);
             QtProtobuf::QProtobufSelfcheckIterator last = it;
             last += it.size();
             while (it != last) {
                 ok = true;
-                handler.deserializer(qPtr, it, newValue);
-                qDebug() << "newValue" << newValue;
+                handler->deserializer(qPtr, it, newValue);
             }
         } else {
-            auto handler = handlers.find(type);
-            if (handler != handlers.end() && handler->second.deserializer) {
-                newValue = handler->second.deserializer(data, jsonType, ok);
+            auto handler = handlers().find(type);
+            if (handler != handlers().end() && handler->second.deserializer) {
+                newValue = handler->second.deserializer(data, value.type, ok);
             }
         }
         return newValue;
     }
 
-    void deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, const char *data, int size) {
-        microjson::JsonObject obj = microjson::parseJsonObject(data, static_cast<size_t>(size));
+    bool deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, const char *data, int size) {
+        bool valid = false;
+        parse(data, size, [this, object, &metaObject, data, &valid](const QProtobufJsonParser &jsonParser) {
+            QProtobufJsonParser::Value value;
+            const char *next = nullptr;
+            if (!jsonParser.isValid() || !jsonParser.readValue(data, value, next)
+                    || value.type != QProtobufJsonParser::ObjectType) {
+                return;
+            }
 
-        for (auto &property : obj) {
-            auto name = property.first;
-            auto it = std::find_if(metaObject.propertyOrdering.begin(),
-                                   metaObject.propertyOrdering.end(),
-                                   [&name](const auto &val)->bool {
-                return val.second == QString::fromStdString(name);
-            });
-            if (it != metaObject.propertyOrdering.end()) {
-                QMetaProperty metaProperty = metaObject.staticMetaObject.property(it->second);
-                auto userType = metaProperty.userType();
-                QByteArray rawValue = QByteArray::fromStdString(property.second.value);
-                if (rawValue == "null" && property.second.type == microjson::JsonObjectType) {
+            //Malformed member fails deserialization same way as unbalanced document
+            valid = jsonParser.forEachMember(value, [this, object, &metaObject](const QProtobufJsonParser::Value &name,
+                                     const QProtobufJsonParser::Value &propertyValue) {
+                const QProtobufFieldInfo *field = metaObject.fieldByJsonName(name.data, name.size);
+                if (field == nullptr) {
+                    return;
+                }
+
+                const QProtobufMetaProperty &metaProperty = field->metaProperty;
+                if (propertyValue.type == QProtobufJsonParser::NullType) {
                     metaProperty.write(object, QVariant());
-                    continue;
+                    return;
                 }
                 bool ok = false;
-                QVariant value = deserializeValue(userType, rawValue, property.second.type, ok);
+                QVariant value = deserializeValue(field->userType, propertyValue, ok);
                 if (ok) {
                     metaProperty.write(object, value);
                 }
+            });
+        });
+
+        if (!valid) {
+            setDeserializationError(QAbstractProtobufSerializer::InvalidFormatError,
+                                    "Message is not valid json object. Deserialization failed");
+        }
+        return valid;
+    }
+
+    /*!
+     * \brief Records first deserialization \a error of current thread
+     */
+    static void setDeserializationError(QAbstractProtobufSerializer::DeserializationError error, const char *errorString) {
+        if (deserializationError != QAbstractProtobufSerializer::NoError) {
+            return;
+        }
+        deserializationError = error;
+        deserializationErrorString = errorString;
+    }
+
+    /*!
+     * \brief Reads next value of list or map that is deserialized using \a it. \a read is called with parser and
+     *        position of value. Iterator is moved after value and following separator, or to the end if
+     *        there are no values left.
+     */
+    template<typename F>
+    static bool readNext(QProtobufSelfcheckIterator &it, char begin, F read) {
+        if (it.size() > 0 && *it == begin) {
+            ++it;
+        }
+
+        const char *next = nullptr;
+        parse(it.data(), it.size(), [&it, &next, &read](const QProtobufJsonParser &jsonParser) {
+            if (!read(jsonParser, it.data(), next)) {
+                next = nullptr;
             }
+        });
+
+        if (next == nullptr) {
+            it += it.size();
+            return false;
         }
+        it += static_cast<int>(next - it.data());
+        return true;
     }
+
+    static thread_local QByteArray *output;
+    static thread_local const QProtobufJsonParser *parser;
+    static thread_local QAbstractProtobufSerializer::DeserializationError deserializationError;//First error of last deserialization
+    static thread_local const char *deserializationErrorString;
 private:
-    static SerializerRegistry handlers;
+    static constexpr int MinReservedSize = 64;
+    static constexpr int MaxReservedSize = 64 * 1024;
     QProtobufJsonSerializer *qPtr;
+    std::atomic<int> sizeEstimate;//Decaying average size of serialized messages
 };
 
-QProtobufJsonSerializerPrivate::SerializerRegistry QProtobufJsonSerializerPrivate::handlers = {};
+thread_local QByteArray *QProtobufJsonSerializerPrivate::output = nullptr;
+thread_local const QProtobufJsonParser *QProtobufJsonSerializerPrivate::parser = nullptr;
+thread_local QAbstractProtobufSerializer::DeserializationError QProtobufJsonSerializerPrivate::deserializationError = QAbstractProtobufSerializer::NoError;
+thread_local const char *QProtobufJsonSerializerPrivate::deserializationErrorString = nullptr;
 
 }
 
@@ -376,23 +563,39 @@ QProtobufJsonSerializer::~QProtobufJsonSerializer() = default;
 
 QByteArray QProtobufJsonSerializer::serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) const
 {
-    return dPtr->serializeObject(object, metaObject);
+    return dPtr->serializeMessage(object, metaObject);
 }
 
-void QProtobufJsonSerializer::deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+QAbstractProtobufSerializer::DeserializationError QProtobufJsonSerializer::deserializationError() const
 {
+    return QProtobufJsonSerializerPrivate::deserializationError;
+}
+
+QString QProtobufJsonSerializer::deserializationErrorString() const
+{
+    return QString::fromLatin1(QProtobufJsonSerializerPrivate::deserializationErrorString);
+}
+
+bool QProtobufJsonSerializer::deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+{
+    QProtobufJsonSerializerPrivate::deserializationError = NoError;
+    QProtobufJsonSerializerPrivate::deserializationErrorString = nullptr;
     dPtr->deserializeObject(object, metaObject, data.data(), data.size());
+    return QProtobufJsonSerializerPrivate::deserializationError == NoError;
 }
 
 QByteArray QProtobufJsonSerializer::serializeObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &/*metaProperty*/) const
 {
-    return dPtr->serializeObject(object, metaObject);
+    return QProtobufJsonSerializerPrivate::write([this, object, &metaObject](QByteArray &out) {
+        dPtr->writeObject(object, metaObject, out);
+    });
 }
 
-void QProtobufJsonSerializer::deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
+bool QProtobufJsonSerializer::deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
 {
-    dPtr->deserializeObject(object, metaObject, it.data(), it.size());
+    bool ok = dPtr->deserializeObject(object, metaObject, it.data(), it.size());
     it += it.size();
+    return ok;
 }
 
 QByteArray QProtobufJsonSerializer::serializeListBegin(const QProtobufMetaProperty &/*metaProperty*/) const
@@ -402,7 +605,10 @@ QByteArray QProtobufJsonSerializer::serializeListBegin(const QProtobufMetaProper
 
 QByteArray QProtobufJsonSerializer::serializeListObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &/*metaProperty*/) const
 {
-    return dPtr->serializeObject(object, metaObject) + ",";
+    return QProtobufJsonSerializerPrivate::write([this, object, &metaObject](QByteArray &out) {
+        dPtr->writeObject(object, metaObject, out);
+        out.append(',');
+    });
 }
 
 QByteArray QProtobufJsonSerializer::serializeListEnd(QByteArray &buffer, const QProtobufMetaProperty &/*metaProperty*/) const
@@ -415,21 +621,14 @@ QByteArray QProtobufJsonSerializer::serializeListEnd(QByteArray &buffer, const Q
 
 bool QProtobufJsonSerializer::deserializeListObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
 {
-    if (*it == '[') {
-        qDebug() << "Begin of list";
-        ++it;
-    }
-
-    size_t i = 0;
-    microjson::JsonProperty property;
-    if (microjson::extractValue(it.data(), static_cast<size_t>(it.size()), i, ']', property)) {
-        dPtr->deserializeObject(object, metaObject, it.data() + property.valueBegin, property.valueSize());
-    } else {
-        it += it.size();
-        return false;
-    }
-    it += i;
-    return true;
+    return QProtobufJsonSerializerPrivate::readNext(it, '[', [this, object, &metaObject](const QProtobufJsonParser &jsonParser,
+                                                    const char *position, const char *&next) {
+        QProtobufJsonParser::Value listValue;
+        if (!jsonParser.readValue(position, listValue, next)) {
+            return false;
+        }
+        return dPtr->deserializeObject(object, metaObject, listValue.data, listValue.size);
+    });
 }
 
 QByteArray QProtobufJsonSerializer::serializeMapBegin(const QProtobufMetaProperty &/*metaProperty*/) const
@@ -438,7 +637,12 @@ QByteArray QProtobufJsonSerializer::serializeMapBegin(const QProtobufMetaPropert
 }
 QByteArray QProtobufJsonSerializer::serializeMapPair(const QVariant &key, const QVariant &value, const QProtobufMetaProperty &metaProperty) const
 {
-    return QByteArray("\"") + key.toString().toUtf8() + "\":" + dPtr->serializeValue(value, metaProperty) + ",";
+    return QProtobufJsonSerializerPrivate::write([this, &key, &value, &metaProperty](QByteArray &out) {
+        QProtobufJsonCodec::writeString(key.toString(), out);
+        out.append(':');
+        dPtr->writeValue(value, metaProperty, out);
+        out.append(',');
+    });
 }
 
 QByteArray QProtobufJsonSerializer::serializeMapEnd(QByteArray &buffer, const QProtobufMetaProperty &/*metaProperty*/) const
@@ -451,68 +655,70 @@ QByteArray QProtobufJsonSerializer::serializeMapEnd(QByteArray &buffer, const QP
 
 bool QProtobufJsonSerializer::deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it) const
 {
-    if (*it == '{') {
-        qDebug() << "Begin of map";
-        ++it;
-    }
-
-    size_t i = 0;
-    microjson::JsonProperty property;
-    if (microjson::extractProperty(it.data(), static_cast<size_t>(it.size()), i, '}', property)) {
+    return QProtobufJsonSerializerPrivate::readNext(it, '{', [this, &key, &value](const QProtobufJsonParser &jsonParser,
+                                                    const char *position, const char *&next) {
+        QProtobufJsonParser::Value keyValue;
+        QProtobufJsonParser::Value mapValue;
+        if (!jsonParser.readMember(position, keyValue, mapValue, next)) {
+            return false;
+        }
         bool ok = false;
-        key = dPtr->deserializeValue(key.userType(), QByteArray(it.data() + property.nameBegin, property.nameSize()), microjson::JsonStringType, ok);
+        key = dPtr->deserializeValue(key.userType(), keyValue, ok);
         if (!ok) {
             key = QVariant();
         }
-        value = dPtr->deserializeValue(value.userType(), QByteArray(it.data() + property.valueBegin, property.valueSize()), property.type, ok);
+        value = dPtr->deserializeValue(value.userType(), mapValue, ok);
         if (!ok) {
             value = QVariant();
         }
-    } else {
-        it += it.size();
-        return false;
-    }
-    it += i;
-    return true;
+        return true;
+    });
 }
 
 QByteArray QProtobufJsonSerializer::serializeEnum(int64 value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &/*metaProperty*/) const
 {
-    return QByteArray("\"") + metaEnum.key(static_cast<int>(value)) + "\"";
+    return QProtobufJsonSerializerPrivate::write([value, &metaEnum](QByteArray &out) {
+        out.append('"');
+        out.append(metaEnum.key(static_cast<int>(value)));
+        out.append('"');
+    });
 }
 
 QByteArray QProtobufJsonSerializer::serializeEnumList(const QList<int64> &values, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &/*metaProperty*/) const
 {
-    QByteArray result = "[";
-    for (auto value : values) {
-        result.append("\"");
-        result.append(metaEnum.key(static_cast<int>(value)));
-        result.append("\",");
-    }
-    if (values.size() > 0) {
-        result.resize(result.size() - 1);
-    }
-    result.append("]");
-    return result;
+    return QProtobufJsonSerializerPrivate::write([&values, &metaEnum](QByteArray &out) {
+        out.append('[');
+        for (int i = 0; i < values.size(); i++) {
+            if (i > 0) {
+                out.append(',');
+            }
+            out.append('"');
+            out.append(metaEnum.key(static_cast<int>(values.at(i))));
+            out.append('"');
+        }
+        out.append(']');
+    });
 }
 
-void QProtobufJsonSerializer::deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const
+bool QProtobufJsonSerializer::deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const
 {
-    value = metaEnum.keyToValue(it.data());
+    //Value refers source buffer that is not null-terminated
+    value = metaEnum.keyToValue(QByteArray(it.data(), it.size()).constData());
     it += it.size();
+    return true;
 }
 
-void QProtobufJsonSerializer::deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const
+bool QProtobufJsonSerializer::deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const
 {
-    auto arrayValues = microjson::parseJsonArray(it.data(), static_cast<size_t>(it.size()));
-
-    for (auto &arrayValue : arrayValues) {
-        if (arrayValue.value == "null") {
+    QProtobufJsonSerializerPrivate::forEachElement(QByteArray::fromRawData(it.data(), it.size()),
+                                                   [&value, &metaEnum](const QProtobufJsonParser::Value &arrayValue) {
+        if (arrayValue.type == QProtobufJsonParser::NullType) {
             value.append(metaEnum.value(0));
         } else {
-             value.append(metaEnum.keyToValue(arrayValue.value.c_str()));
+            value.append(metaEnum.keyToValue(QByteArray(arrayValue.data, arrayValue.size).constData()));
         }
-    }
+    });
 
     it += it.size();
+    return true;
 }
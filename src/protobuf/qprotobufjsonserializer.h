@@ -35,6 +35,8 @@ class QProtobufJsonSerializerPrivate;
 /*!
 *  \ingroup QtProtobuf
  * \brief The QProtobufJsonSerializer class
+ *
+ * \details Serializer is thread-safe: single instance may be used from several threads concurrently
  */
 class Q_PROTOBUF_EXPORT QProtobufJsonSerializer : public QAbstractProtobufSerializer
 {
@@ -42,12 +44,15 @@ public:
     QProtobufJsonSerializer();
     ~QProtobufJsonSerializer();
 
+    DeserializationError deserializationError() const override;
+    QString deserializationErrorString() const override;
+
 protected:
     QByteArray serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) const  override;
-    void deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
 
     QByteArray serializeObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const override;
-    void deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const override;
 
     QByteArray serializeListBegin(const QProtobufMetaProperty &metaProperty) const override;
     QByteArray serializeListObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const override;
@@ -64,8 +69,8 @@ protected:
     QByteArray serializeEnum(int64 value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
     QByteArray serializeEnumList(const QList<int64> &value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
 
-    void deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
-    void deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
 private:
     std::unique_ptr<QProtobufJsonSerializerPrivate> dPtr;
 };
@@ -27,17 +27,37 @@
 
 #include "qtprotobufglobal.h"
 #include <QObject>
+#include <QByteArray>
 #if defined(QT_QML_LIB) // TODO: Check how detect this in Qt6
 #  include <QQmlEngine>
 #endif
 
 #include <memory>
 #include <type_traits>
+#include <utility>
+
+namespace QtProtobuf {
+class QProtobufMetaObject;
+}
+
+namespace QtProtobufPrivate {
+/*!
+ * \private
+ * \brief Deserializes message kept serialized by QProtobufLazyMessagePointer into \a object using
+ *        QProtobufSerializer \a options of serializer that kept message serialized
+ * \return false if \a data is malformed, \a object is reset to default values in this case
+ */
+extern Q_PROTOBUF_EXPORT bool deserializeLazyMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QByteArray &data,
+                                                     int options);
+}
 
 template <typename T>
 class QProtobufLazyMessagePointer {//TODO: final?
 public:
-    QProtobufLazyMessagePointer(T *p = nullptr) : m_ptr(p) {}
+    QProtobufLazyMessagePointer(T *p = nullptr) : m_ptr(p)
+      , m_options(0)
+      , m_serialized(false)
+      , m_decodeError(false) {}
 
     virtual ~QProtobufLazyMessagePointer() {
         checkAndRelease();
@@ -45,27 +65,75 @@ public:
     }
 
     typename std::add_lvalue_reference<T>::type operator *() const {
-        if (m_ptr == nullptr) {
-            m_ptr.reset(new T);
-        }
-        return *m_ptr;
+        return *get();
     }
 
-    T *operator->() const noexcept {
-        if (m_ptr == nullptr) {
-            m_ptr.reset(new T);
-        }
-        m_ptr.operator->();
+    T *operator->() const {
+        return get();
     }
 
     T *get() const {
         if (m_ptr == nullptr) {
             m_ptr.reset(new T);
+            if (m_serialized) {
+                //Message kept serialized is deserialized on first access
+                m_serialized = false;
+                m_decodeError = !QtProtobufPrivate::deserializeLazyMessage(m_ptr.get(), T::protobufMetaObject, m_serializedData, m_options);
+                m_serializedData.clear();
+            }
         }
         return m_ptr.get();
     }
 
+    /*!
+     * \brief Keeps serialized message \a data instead of message object. Message is deserialized from
+     *        \a data on first access using QProtobufSerializer \a options, until that \a data is serialized
+     *        back as is
+     */
+    void setSerializedData(const QByteArray &data, int options = 0) const {
+        checkAndRelease();
+        QObject::disconnect(m_destroyed);
+        m_ptr.reset();
+        m_serializedData = data;
+        m_options = options;
+        m_serialized = true;
+        m_decodeError = false;
+    }
+
+    /*!
+     * \brief Returns true if message kept serialized was malformed when it was deserialized on first access
+     *
+     * \details Message is left with default values in this case. Reason of failure is available using
+     *          QAbstractProtobufSerializer::deserializationError() in thread where message was accessed.
+     */
+    bool hasDecodeError() const {
+        return m_decodeError;
+    }
+
+    /*!
+     * \brief Returns true if message is kept serialized and was not accessed yet
+     */
+    bool isSerialized() const {
+        return m_serialized;
+    }
+
+    /*!
+     * \brief Returns serialized message data if isSerialized() is true
+     */
+    const QByteArray &serializedData() const {
+        return m_serializedData;
+    }
+
     bool operator ==(const QProtobufLazyMessagePointer &other) const {
+        if (m_serialized && other.m_serialized && m_serializedData == other.m_serializedData) {
+            return true;
+        }
+        if (m_serialized) {
+            get();
+        }
+        if (other.m_serialized) {
+            other.get();
+        }
         return (m_ptr == nullptr && other.m_ptr == nullptr)
                 || (other.m_ptr == nullptr && *m_ptr == T{})
                 || (m_ptr == nullptr && *other.m_ptr == T{})
@@ -77,6 +145,9 @@ public:
     }
 
     void reset(T *p) const {
+        m_serialized = false;
+        m_decodeError = false;
+        m_serializedData.clear();
         checkAndRelease();
         QObject::disconnect(m_destroyed);
         m_destroyed = QObject::connect(p, &QObject::destroyed, [this] {
@@ -87,13 +158,22 @@ public:
         m_ptr.reset(p);
     }
 
-    QProtobufLazyMessagePointer(QProtobufLazyMessagePointer &&other) : m_ptr(std::move(other.m_ptr)) {}
+    QProtobufLazyMessagePointer(QProtobufLazyMessagePointer &&other) : m_ptr(std::move(other.m_ptr))
+      , m_serializedData(std::move(other.m_serializedData))
+      , m_options(other.m_options)
+      , m_serialized(std::exchange(other.m_serialized, false))
+      , m_decodeError(std::exchange(other.m_decodeError, false)) {}
     QProtobufLazyMessagePointer &operator =(QProtobufLazyMessagePointer &&other) {
         m_ptr = std::move(other.m_ptr);
+        m_serializedData = std::move(other.m_serializedData);
+        m_options = other.m_options;
+        m_serialized = std::exchange(other.m_serialized, false);
+        m_decodeError = std::exchange(other.m_decodeError, false);
+        return *this;
     }
 
     explicit operator bool() const noexcept {
-        return m_ptr.operator bool();
+        return m_serialized || m_ptr.operator bool();
     }
 
 private:
@@ -113,4 +193,8 @@ private:
     QProtobufLazyMessagePointer &operator =(const QProtobufLazyMessagePointer&) = delete;
     mutable std::unique_ptr<T> m_ptr;
     mutable QMetaObject::Connection m_destroyed;
+    mutable QByteArray m_serializedData;
+    mutable int m_options;//Options of serializer that kept message serialized
+    mutable bool m_serialized;
+    mutable bool m_decodeError;
 };
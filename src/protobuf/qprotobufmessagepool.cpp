@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufmessagepool.h"
+#include "qabstractprotobufserializer.h"
+#include "qprotobufmetaobject.h"
+
+#include <QThread>
+#include <QHash>
+
+#include <vector>
+
+using namespace QtProtobuf;
+
+namespace {
+thread_local QProtobufMessagePool *activePool = nullptr;
+}
+
+//! \private
+struct QProtobufMessagePool::Data {
+    Data(int _capacity) : thread(QThread::currentThread())
+      , capacity(_capacity)
+      , count(0)
+      , closed(false) {}
+
+    QThread *thread;
+    int capacity;
+    int count;
+    bool closed;//Set when pool is destroyed, messages released afterwards are deleted
+    QHash<const QMetaObject *, std::vector<QObject *>> idle;
+};
+
+QProtobufMessagePool::Scope::Scope(QProtobufMessagePool *pool) : m_previous(activePool)
+{
+    Q_ASSERT_X(pool == nullptr || pool->dPtr->thread == QThread::currentThread(), "QProtobufMessagePool",
+               "Pool is used in thread other than one where it was created");
+    activePool = pool;
+}
+
+QProtobufMessagePool::Scope::~Scope()
+{
+    activePool = m_previous;
+}
+
+QProtobufMessagePool::QProtobufMessagePool(int capacity) : dPtr(new Data(capacity))
+{
+}
+
+QProtobufMessagePool::~QProtobufMessagePool()
+{
+    Q_ASSERT_X(activePool != this, "QProtobufMessagePool", "Pool is destroyed while its scope is active");
+    dPtr->closed = true;
+    clear();
+}
+
+int QProtobufMessagePool::capacity() const
+{
+    return dPtr->capacity;
+}
+
+int QProtobufMessagePool::count() const
+{
+    return dPtr->count;
+}
+
+void QProtobufMessagePool::clear()
+{
+    //Idle messages are detached from pool first, their nested messages may be released to pool when deleted
+    QHash<const QMetaObject *, std::vector<QObject *>> idle;
+    idle.swap(dPtr->idle);
+    dPtr->count = 0;
+    for (auto &objects : idle) {
+        for (QObject *object : objects) {
+            delete object;
+        }
+    }
+}
+
+QProtobufMessagePool *QProtobufMessagePool::current()
+{
+    return activePool;
+}
+
+QObject *QProtobufMessagePool::take(const QMetaObject *type)
+{
+    auto it = dPtr->idle.find(type);
+    if (it == dPtr->idle.end() || it->empty()) {
+        return nullptr;
+    }
+    QObject *object = it->back();
+    it->pop_back();
+    --dPtr->count;
+    return object;
+}
+
+void QProtobufMessagePool::Recycler::operator()(QObject *object) const
+{
+    if (data->closed || QThread::currentThread() != data->thread || object->thread() != data->thread
+            || object->parent() != nullptr) {
+        delete object;
+        return;
+    }
+
+    //Connections and values of released message are not passed to its next user. Nested messages of
+    //released message are returned to pool while it's cleared, so container is looked up afterwards
+    object->disconnect();
+    QAbstractProtobufSerializer::clearMessage(object, *metaObject);
+
+    std::vector<QObject *> &objects = data->idle[object->metaObject()];
+    if (static_cast<int>(objects.size()) >= data->capacity) {
+        delete object;
+        return;
+    }
+    objects.push_back(object);
+    ++data->count;
+}
@@ -0,0 +1,149 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufMessagePool
+
+#include "qtprotobufglobal.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+namespace QtProtobuf {
+
+class QProtobufMetaObject;
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufMessagePool class keeps released message objects to reuse them for deserialization
+ *
+ * \details Pool is opt-in: it's used by deserialization in thread where QProtobufMessagePool::Scope with
+ *          this pool is active. Nested and repeated messages are taken from pool instead of being allocated,
+ *          repeated messages return to pool once last QSharedPointer to them is released. So parsing of
+ *          series of messages reuses objects together with their QObject private data, and only reference
+ *          counter of repeated message is allocated per element.
+ *
+ *          Message returned to pool is disconnected and reset to default values. Pool belongs to thread
+ *          where it's created: messages released in other threads, or after pool is destroyed, are deleted.
+ *          Idle messages are deleted when pool is cleared or destroyed.
+ *
+ * \code
+ * QProtobufMessagePool pool;
+ * for (const QByteArray &data : input) {
+ *     QProtobufMessagePool::Scope scope(&pool);
+ *     message.deserialize(&serializer, data);
+ * }
+ * \endcode
+ */
+class Q_PROTOBUF_EXPORT QProtobufMessagePool
+{
+public:
+    /*!
+     * \brief Scope makes \a pool active in current thread while it exists. Previously active pool is restored
+     *        when scope is destroyed.
+     */
+    class Q_PROTOBUF_EXPORT Scope
+    {
+    public:
+        explicit Scope(QProtobufMessagePool *pool);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        QProtobufMessagePool *m_previous;
+    };
+
+    /*!
+     * \brief Constructs pool that keeps at most \a capacity idle messages of each type
+     */
+    explicit QProtobufMessagePool(int capacity = DefaultCapacity);
+    ~QProtobufMessagePool();
+
+    /*!
+     * \brief Returns maximum number of idle messages of each type
+     */
+    int capacity() const;
+
+    /*!
+     * \brief Returns number of idle messages kept by pool
+     */
+    int count() const;
+
+    /*!
+     * \brief Deletes all idle messages
+     */
+    void clear();
+
+    /*!
+     * \brief Returns pool that is active in current thread, nullptr if there is no active pool
+     */
+    static QProtobufMessagePool *current();
+
+    /*!
+     * \brief Returns message of type T taken from active pool, or allocated if there is no active pool or
+     *        it has no idle messages of type T. Caller owns the message, it's deleted as usual.
+     */
+    template <typename T>
+    static T *create() {
+        QProtobufMessagePool *pool = current();
+        QObject *object = pool != nullptr ? pool->take(&T::staticMetaObject) : nullptr;
+        return object != nullptr ? static_cast<T *>(object) : new T;
+    }
+
+    /*!
+     * \brief Same as create(), but message returns to active pool once last reference to it is released
+     */
+    template <typename T>
+    static QSharedPointer<T> createShared() {
+        QProtobufMessagePool *pool = current();
+        if (pool == nullptr) {
+            return QSharedPointer<T>::create();
+        }
+        QObject *object = pool->take(&T::staticMetaObject);
+        return QSharedPointer<T>(object != nullptr ? static_cast<T *>(object) : new T,
+                                 Recycler{pool->dPtr, &T::protobufMetaObject});
+    }
+
+private:
+    Q_DISABLE_COPY(QProtobufMessagePool)
+
+    enum {
+        DefaultCapacity = 4096
+    };
+
+    struct Data;
+
+    //! \private Deleter of shared messages, returns message to pool or deletes it
+    struct Q_PROTOBUF_EXPORT Recycler {
+        QSharedPointer<Data> data;
+        const QProtobufMetaObject *metaObject;
+        void operator()(QObject *object) const;
+    };
+
+    QObject *take(const QMetaObject *type);
+
+    QSharedPointer<Data> dPtr;
+};
+
+}
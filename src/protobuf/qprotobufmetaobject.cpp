@@ -24,9 +24,175 @@
  */
 
 #include "qprotobufmetaobject.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+
+#include <algorithm>
+#include <cstring>
+
 using namespace QtProtobuf;
-QProtobufMetaObject::QProtobufMetaObject(const QMetaObject &_staticMetaObject, const QProtobufPropertyOrdering &_propertyOrdering)
+
+namespace {
+//Dense lookup table is used while it's not much bigger than descriptors array
+constexpr int DenseIndexExtraSlots = 16;
+
+//Meta objects of all message types, registered while generated static meta objects are constructed
+struct MetaObjectRegistry {
+    QReadWriteLock lock;
+    QHash<const QMetaObject *, const QProtobufMetaObject *> metaObjects;
+};
+
+MetaObjectRegistry &metaObjectRegistry()
+{
+    static MetaObjectRegistry registry;
+    return registry;
+}
+}
+
+QProtobufFieldInfo::QProtobufFieldInfo(const QMetaProperty &_metaProperty, int fieldNumber, const QString &jsonName)
+    : metaProperty(_metaProperty, fieldNumber, jsonName)
+    , userType(_metaProperty.userType())
+    , handler(QtProtobufPrivate::findHandler(userType))
+    , jsonKey('"' + jsonName.toUtf8() + "\":")
+{
+}
+
+QProtobufMetaObject::QProtobufMetaObject(const QMetaObject &_staticMetaObject, const QProtobufPropertyOrdering &_propertyOrdering,
+                                         UnknownFieldsAccessor _unknownFields,
+                                         TypedSerializer _typedSerializer, TypedDeserializer _typedDeserializer)
     : staticMetaObject(_staticMetaObject)
     , propertyOrdering(_propertyOrdering)
+    , unknownFields(_unknownFields)
+    , typedSerializer(_typedSerializer)
+    , typedDeserializer(_typedDeserializer)
+    , m_unknownFieldsCount(0)
+{
+    MetaObjectRegistry &registry = metaObjectRegistry();
+    QWriteLocker locker(&registry.lock);
+    registry.metaObjects.insert(&staticMetaObject, this);
+}
+
+const QProtobufMetaObject *QProtobufMetaObject::forType(int userType)
+{
+    const QMetaObject *metaObject = QMetaType::metaObjectForType(userType);
+    if (metaObject == nullptr) {
+        return nullptr;
+    }
+
+    MetaObjectRegistry &registry = metaObjectRegistry();
+    QReadLocker locker(&registry.lock);
+    return registry.metaObjects.value(metaObject, nullptr);
+}
+
+const std::vector<QProtobufFieldInfo> &QProtobufMetaObject::fields() const
+{
+    std::call_once(m_fieldsFlag, [this] { buildFields(); });
+    return m_fields;
+}
+
+const QProtobufFieldInfo *QProtobufMetaObject::field(int fieldNumber) const
+{
+    const auto &sortedFields = fields();
+    if (!m_denseIndex.empty()) {
+        if (fieldNumber <= 0 || fieldNumber >= static_cast<int>(m_denseIndex.size())) {
+            return nullptr;
+        }
+        int index = m_denseIndex[fieldNumber];
+        return index < 0 ? nullptr : &sortedFields[index];
+    }
+
+    auto it = std::lower_bound(sortedFields.begin(), sortedFields.end(), fieldNumber, [](const QProtobufFieldInfo &info, int number) {
+        return info.metaProperty.protoFieldIndex() < number;
+    });
+    if (it == sortedFields.end() || it->metaProperty.protoFieldIndex() != fieldNumber) {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+const QProtobufFieldInfo *QProtobufMetaObject::fieldByJsonName(const char *name, int size) const
+{
+    fields();//Index is built together with field descriptors
+    size_t mask = m_jsonNameIndex.size() - 1;
+    uint hash = qHashBits(name, static_cast<size_t>(size));
+    for (size_t i = hash & mask; m_jsonNameIndex[i].field != nullptr; i = (i + 1) & mask) {
+        const JsonNameSlot &slot = m_jsonNameIndex[i];
+        if (slot.hash == hash && slot.name.size() == size
+                && memcmp(slot.name.constData(), name, static_cast<size_t>(size)) == 0) {
+            return slot.field;
+        }
+    }
+    return nullptr;
+}
+
+quint64 QProtobufMetaObject::unknownFieldsCount() const
+{
+    return m_unknownFieldsCount.load(std::memory_order_relaxed);
+}
+
+bool QProtobufMetaObject::countUnknownField() const
+{
+    return m_unknownFieldsCount.fetch_add(1, std::memory_order_relaxed) == 0;
+}
+
+void QProtobufMetaObject::buildFields() const
+{
+    std::vector<const QProtobufPropertyOrdering::value_type *> ordering;
+    ordering.reserve(propertyOrdering.size());
+    for (const auto &field : propertyOrdering) {
+        Q_ASSERT_X(field.first < 536870912 && field.first > 0, "", "fieldIndex is out of range");
+        ordering.push_back(&field);
+    }
+    std::sort(ordering.begin(), ordering.end(), [](const QProtobufPropertyOrdering::value_type *a, const QProtobufPropertyOrdering::value_type *b) {
+        return a->first < b->first;
+    });
+
+    m_fields.reserve(ordering.size());
+    for (const auto field : ordering) {
+        //jsonName is referenced by QProtobufMetaProperty, so it's taken from static property ordering
+        m_fields.emplace_back(staticMetaObject.property(field->second.qtProperty), field->first, field->second.jsonName);
+    }
+
+    buildJsonNameIndex();
+
+    if (m_fields.empty()) {
+        return;
+    }
+
+    int maxFieldNumber = m_fields.back().metaProperty.protoFieldIndex();
+    if (maxFieldNumber <= static_cast<int>(m_fields.size()) * 2 + DenseIndexExtraSlots) {
+        m_denseIndex.assign(maxFieldNumber + 1, -1);
+        for (size_t i = 0; i < m_fields.size(); i++) {
+            m_denseIndex[m_fields[i].metaProperty.protoFieldIndex()] = static_cast<int>(i);
+        }
+    }
+}
+
+void QProtobufMetaObject::buildJsonNameIndex() const
+{
+    //Each field is found by json name and by property name, that is name of field in .proto file.
+    //Table is kept at most half full, so probe sequences are short.
+    size_t capacity = 1;
+    while (capacity < m_fields.size() * 4) {
+        capacity <<= 1;
+    }
+    m_jsonNameIndex.assign(capacity, {0, QByteArray(), nullptr});
+    for (const auto &field : m_fields) {
+        insertJsonName(field.metaProperty.jsonPropertyName().toUtf8(), &field);
+        insertJsonName(QByteArray(field.metaProperty.name()), &field);
+    }
+}
+
+void QProtobufMetaObject::insertJsonName(const QByteArray &name, const QProtobufFieldInfo *field) const
 {
+    size_t mask = m_jsonNameIndex.size() - 1;
+    uint hash = qHashBits(name.constData(), static_cast<size_t>(name.size()));
+    size_t i = hash & mask;
+    for (; m_jsonNameIndex[i].field != nullptr; i = (i + 1) & mask) {
+        if (m_jsonNameIndex[i].hash == hash && m_jsonNameIndex[i].name == name) {
+            return;//Json name matches property name
+        }
+    }
+    m_jsonNameIndex[i] = {hash, name, field};
 }
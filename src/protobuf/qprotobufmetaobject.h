@@ -27,10 +27,36 @@
 
 #include "qtprotobufglobal.h"
 #include "qtprotobuftypes.h"
+#include "qabstractprotobufserializer.h"
+#include "qprotobufmetaproperty.h"
+#include "qprotobufunknownfields.h"
 
 #include <QMetaObject>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 namespace QtProtobuf {
 
+class QProtobufTypedWriter;
+class QProtobufTypedReader;
+
+/*!
+ * \ingroup QtProtobuf
+ * \private
+ * \brief The QProtobufFieldInfo struct is precomputed descriptor of message field
+ */
+struct Q_PROTOBUF_EXPORT QProtobufFieldInfo
+{
+    QProtobufFieldInfo(const QMetaProperty &metaProperty, int fieldNumber, const QString &jsonName);
+
+    QProtobufMetaProperty metaProperty;/*!< Qt property bound to field number and json name */
+    int userType;/*!< Meta type id of property */
+    const QtProtobufPrivate::SerializationHandler *handler;/*!< Handler resolved for non-basic types, nullptr if not registered yet */
+    QByteArray jsonKey;/*!< Quoted UTF-8 json name followed by colon, written by json serializer as is */
+};
+
 /*!
  * \ingroup QtProtobuf
  * \private
@@ -39,11 +65,85 @@ namespace QtProtobuf {
 class Q_PROTOBUF_EXPORT QProtobufMetaObject
 {
 public:
-    QProtobufMetaObject(const QMetaObject &staticMetaObject, const QProtobufPropertyOrdering &propertyOrdering);
+    /*!
+     * \brief TypedSerializer is generated function that serializes message fields without reflection
+     */
+    using TypedSerializer = void(*)(const QObject *, QProtobufTypedWriter &);
+    /*!
+     * \brief TypedDeserializer is generated function that deserializes message fields without reflection
+     */
+    using TypedDeserializer = void(*)(QObject *, QProtobufTypedReader &);
+    /*!
+     * \brief UnknownFieldsAccessor is generated function that returns unknown fields storage of message
+     */
+    using UnknownFieldsAccessor = QProtobufUnknownFields *(*)(QObject *);
+
+    QProtobufMetaObject(const QMetaObject &staticMetaObject, const QProtobufPropertyOrdering &propertyOrdering,
+                        UnknownFieldsAccessor unknownFields = nullptr,
+                        TypedSerializer typedSerializer = nullptr, TypedDeserializer typedDeserializer = nullptr);
     const QMetaObject &staticMetaObject;
     const QProtobufPropertyOrdering &propertyOrdering;
+    const UnknownFieldsAccessor unknownFields;/*!< nullptr if message doesn't keep unknown fields */
+    const TypedSerializer typedSerializer;/*!< nullptr if typed serializer is not generated */
+    const TypedDeserializer typedDeserializer;/*!< nullptr if typed deserializer is not generated */
+
+    /*!
+     * \brief fields returns message field descriptors sorted by field number
+     */
+    const std::vector<QProtobufFieldInfo> &fields() const;
+
+    /*!
+     * \brief field looks up field descriptor by \a fieldNumber
+     * \return nullptr if message has no field with \a fieldNumber
+     */
+    const QProtobufFieldInfo *field(int fieldNumber) const;
+
+    /*!
+     * \brief fieldByJsonName looks up field descriptor by json name or by name of field in .proto file
+     * \param name UTF-8 encoded name, not required to be null-terminated
+     * \param size Size of \a name in bytes
+     * \return nullptr if message has no field with \a name
+     */
+    const QProtobufFieldInfo *fieldByJsonName(const char *name, int size) const;
+
+    /*!
+     * \brief unknownFieldsCount returns number of unknown fields met while messages of this type were deserialized
+     */
+    quint64 unknownFieldsCount() const;
+
+    /*!
+     * \brief countUnknownField increments unknownFieldsCount()
+     * \return true if it's first unknown field met for messages of this type
+     */
+    bool countUnknownField() const;
+
+    /*!
+     * \brief forType looks up protobuf meta object of message type with meta type identifier \a userType
+     *
+     * \details Both message type and pointer to message type identifiers are accepted
+     * \return nullptr if \a userType is not protobuf message type
+     */
+    static const QProtobufMetaObject *forType(int userType);
+
 private:
     QProtobufMetaObject();
+    void buildFields() const;
+    void buildJsonNameIndex() const;
+    void insertJsonName(const QByteArray &name, const QProtobufFieldInfo *field) const;
+
+    //! \private
+    struct JsonNameSlot {
+        uint hash;
+        QByteArray name;
+        const QProtobufFieldInfo *field;//nullptr if slot is empty
+    };
+
+    //Built on first access: generated code defines metaobject before property ordering
+    mutable std::once_flag m_fieldsFlag;
+    mutable std::vector<QProtobufFieldInfo> m_fields;
+    mutable std::vector<int> m_denseIndex;
+    mutable std::vector<JsonNameSlot> m_jsonNameIndex;//Open addressing hash table, size is power of two
+    mutable std::atomic<quint64> m_unknownFieldsCount;
 };
 
 }
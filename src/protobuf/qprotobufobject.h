@@ -27,6 +27,8 @@
 
 #include "qabstractprotobufserializer.h"
 #include "qprotobufmetaobject.h"
+#include "qprotobuftypedserializer.h"
+#include "qprotobufunknownfields.h"
 #include <unordered_map>
 
 /*!
@@ -43,8 +45,18 @@
 #define Q_DECLARE_PROTOBUF_SERIALIZERS(T)\
     public:\
         QByteArray serialize(QtProtobuf::QAbstractProtobufSerializer *serializer) const { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->serialize<T>(this); }\
-        void deserialize(QtProtobuf::QAbstractProtobufSerializer *serializer, const QByteArray &array) { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); serializer->deserialize<T>(this, array); }\
-    private:
+        QByteArray serialize(QtProtobuf::QAbstractProtobufSerializer *serializer, const QtProtobuf::QProtobufFieldMask &mask) const { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->serialize<T>(this, mask); }\
+        bool serialize(QtProtobuf::QAbstractProtobufSerializer *serializer, QIODevice *device) const { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->serializeTo<T>(this, device); }\
+        int serializedSize(QtProtobuf::QAbstractProtobufSerializer *serializer) const { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->serializedSize<T>(this); }\
+        bool deserialize(QtProtobuf::QAbstractProtobufSerializer *serializer, const QByteArray &array) { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->deserialize<T>(this, array); }\
+        bool deserialize(QtProtobuf::QAbstractProtobufSerializer *serializer, const QByteArray &array, const QtProtobuf::QProtobufFieldMask &mask) { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->deserialize<T>(this, array, mask); }\
+        bool tryDeserialize(QtProtobuf::QAbstractProtobufSerializer *serializer, const QByteArray &array) { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->tryDeserialize<T>(this, array); }\
+        bool mergeFrom(QtProtobuf::QAbstractProtobufSerializer *serializer, const QByteArray &array) { Q_ASSERT_X(serializer != nullptr, "QProtobufObject", "Serializer is null"); return serializer->mergeFrom<T>(this, array); }\
+        const QtProtobuf::QProtobufUnknownFields &unknownFields() const { return m_unknownFields; }\
+        void clearUnknownFields() { m_unknownFields.clear(); }\
+    private:\
+        static QtProtobuf::QProtobufUnknownFields *unknownFieldsOf(QObject *object) { return &(static_cast<T *>(object)->m_unknownFields); }\
+        QtProtobuf::QProtobufUnknownFields m_unknownFields;
 
 /*!
  * \ingroup QtProtobuf
@@ -24,7 +24,6 @@
  */
 
 #include <QByteArray>
-#include <stdexcept>
 
 #include "qtprotobufglobal.h"
 
@@ -35,75 +34,64 @@ namespace QtProtobuf {
 /*!
  * \ingroup QtProtobuf
  * \brief The QProtobufSelfcheckIterator class
+ *
+ * \details Iterator doesn't throw exceptions. Attempt to move iterator out of container bounds leaves
+ *          iterator at the bound it crossed and marks it as invalid, see isValid(). Dereference of iterator
+ *          at the end of container returns 0. Serializer fails deserialization if iterator becomes invalid.
  */
 class Q_PROTOBUF_EXPORT QProtobufSelfcheckIterator
 {
 public:
     QProtobufSelfcheckIterator(const QByteArray &container) : m_sizeLeft(container.size())
       , m_containerSize(container.size())
-      , m_it(container.begin()) {}
+      , m_it(container.begin())
+      , m_valid(true) {}
 
-    QProtobufSelfcheckIterator(const QProtobufSelfcheckIterator &other) : m_sizeLeft(other.m_sizeLeft)
-      , m_containerSize(other.m_containerSize)
-      , m_it(other.m_it) {
-        if (m_sizeLeft > m_containerSize || m_sizeLeft < 0) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
-        }
-    }
+    QProtobufSelfcheckIterator(const QProtobufSelfcheckIterator &other) = default;
 
     explicit operator QByteArray::const_iterator&() { return m_it; }
     explicit operator QByteArray::const_iterator() const { return m_it; }
 
-    char operator *() { return *m_it; }
+    char operator *() {
+        //End of container is never dereferenced, input may be not null-terminated raw data
+        return m_sizeLeft > 0 ? *m_it : 0;
+    }
 
     QProtobufSelfcheckIterator &operator ++() {
-        --m_sizeLeft;
-        if (m_sizeLeft < 0) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
-        }
-        ++m_it;
-        return *this;
+        return operator +=(1);
     }
 
     QProtobufSelfcheckIterator &operator --() {
-        ++m_sizeLeft;
-        if (m_sizeLeft > m_containerSize) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
-        }
-        --m_it;
-        return *this;
+        return operator -=(1);
     }
 
     QProtobufSelfcheckIterator &operator +=(int count) {
-        m_sizeLeft -= count;
-        if (m_sizeLeft < 0) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
+        if (count > m_sizeLeft) {
+            count = m_sizeLeft;
+            m_valid = false;
         }
+        m_sizeLeft -= count;
         m_it += count;
         return *this;
     }
 
     QProtobufSelfcheckIterator &operator -=(int count) {
-        m_sizeLeft += count;
-        if (m_sizeLeft > m_containerSize) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
+        if (count > m_containerSize - m_sizeLeft) {
+            count = m_containerSize - m_sizeLeft;
+            m_valid = false;
         }
+        m_sizeLeft += count;
         m_it -= count;
         return *this;
     }
 
-    QProtobufSelfcheckIterator &operator =(const QProtobufSelfcheckIterator &other) {
-        if (this == &other) {
-            return *this;
-        }
+    QProtobufSelfcheckIterator &operator =(const QProtobufSelfcheckIterator &other) = default;
 
-        m_containerSize = other.m_containerSize;
-        m_sizeLeft = other.m_sizeLeft;
-        if (m_sizeLeft > m_containerSize || m_sizeLeft < 0) {
-            throw std::out_of_range("Container is less than required fields number. Deserialization failed");
-        }
-        m_it = other.m_it;
-        return *this;
+    /*!
+     * \brief Returns false if iterator was moved out of container bounds
+     */
+    bool isValid() const {
+        return m_valid;
     }
 
     bool operator ==(const QProtobufSelfcheckIterator &other) const {
@@ -129,10 +117,30 @@ public:
     int size() const {
         return m_sizeLeft;
     }
+
+    /*!
+     * \brief Makes iterator that is bounded by \a length bytes starting from current position
+     *
+     * \details Sub-range iterator refers the same buffer, so nested length-delimited fields could be
+     *          deserialized in place without copying. In case if \a length exceeds amount of bytes left,
+     *          empty invalid iterator is returned.
+     */
+    QProtobufSelfcheckIterator subRange(int length) const {
+        if (length < 0 || length > m_sizeLeft) {
+            return QProtobufSelfcheckIterator(m_it, 0, false);
+        }
+        return QProtobufSelfcheckIterator(m_it, length, true);
+    }
 private:
+    QProtobufSelfcheckIterator(QByteArray::const_iterator it, int size, bool valid) : m_sizeLeft(size)
+      , m_containerSize(size)
+      , m_it(it)
+      , m_valid(valid) {}
+
     int m_sizeLeft;
     int m_containerSize;
     QByteArray::const_iterator m_it;
+    bool m_valid;
 };
 
 inline QProtobufSelfcheckIterator operator +(const QProtobufSelfcheckIterator &it, int lenght) {
@@ -29,6 +29,10 @@
 #include "qprotobufmetaproperty.h"
 #include "qprotobufmetaobject.h"
 
+#include <QScopedValueRollback>
+
+#include <algorithm>
+
 namespace QtProtobuf {
 
 template<>
@@ -56,9 +60,10 @@ void QProtobufSerializerPrivate::deserializeList<QByteArray>(QProtobufSelfcheckI
 {
     qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
-    QByteArrayList list = previousValue.value<QByteArrayList>();
-    list.append(deserializeLengthDelimited(it));
-    previousValue.setValue(list);
+    QByteArray value = deserializeLengthDelimited(it);
+    if (!hasDeserializationError()) {
+        QtProtobufPrivate::valueRef<QByteArrayList>(previousValue).append(value);
+    }
 }
 
 template<>
@@ -66,54 +71,173 @@ void QProtobufSerializerPrivate::deserializeList<QString>(QProtobufSelfcheckIter
 {
     qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
-    QStringList list = previousValue.value<QStringList>();
-    QByteArray value = deserializeLengthDelimited(it);
-    list.append(QString::fromUtf8(value));
-    previousValue.setValue(list);
+    QProtobufSelfcheckIterator value = deserializeLengthDelimitedRange(it);
+    if (!hasDeserializationError()) {
+        QtProtobufPrivate::valueRef<QStringList>(previousValue).append(QString::fromUtf8(value.data(), value.size()));
+    }
+}
+
+namespace {
+//Unlike basic types, messages, lists, maps and enums are serialized using handlers from common registry
+const QtProtobufPrivate::SerializationHandler *registeredHandler(int userType)
+{
+    const QtProtobufPrivate::SerializationHandler *handler = QtProtobufPrivate::findHandler(userType);
+    if (handler == nullptr) {
+        qProtoCritical() << "No serialization handler registered for type" << QMetaType::typeName(userType);
+    }
+    return handler;
+}
 }
 
 QProtobufSerializer::~QProtobufSerializer() = default;
 
-QProtobufSerializer::QProtobufSerializer() : dPtr(new QProtobufSerializerPrivate(this))
+QProtobufSerializer::QProtobufSerializer(Options options) : dPtr(new QProtobufSerializerPrivate(this))
 {
+    dPtr->options = options;
+}
+
+QProtobufSerializer::Options QProtobufSerializer::options() const
+{
+    return dPtr->options;
+}
+
+void QProtobufSerializer::setOptions(Options options)
+{
+    dPtr->options = options;
 }
 
 QByteArray QProtobufSerializer::serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) const
 {
-    QByteArray result;
-    for (const auto &field : metaObject.propertyOrdering) {
-        int propertyIndex = field.second;
-        int fieldIndex = field.first;
-        Q_ASSERT_X(fieldIndex < 536870912 && fieldIndex > 0, "", "fieldIndex is out of range");
-        QMetaProperty metaProperty = metaObject.staticMetaObject.property(propertyIndex);
-        const char *propertyName = metaProperty.name();
-        QVariant propertyValue = object->property(propertyName);
-        result.append(dPtr->serializeProperty(propertyValue, QProtobufMetaProperty(metaProperty,
-                                                                                   fieldIndex,
-                                                                                   field.second)));
+    return dPtr->serializeMessage(object, metaObject, nullptr);
+}
+
+bool QProtobufSerializer::serializeMessageTo(const QObject *object, const QProtobufMetaObject &metaObject, QIODevice *device) const
+{
+    //Sizes are calculated same as for serializeMessage(), at writing pass message is written to device
+    //by chunks, using buffer of OutputChunkSize bytes
+    QProtobufSerializerPrivate::SerializationContext context(dPtr.get());
+    QScopedValueRollback<QProtobufSerializerPrivate::SerializationContext *> scope(QProtobufSerializerPrivate::context, &context);
+    dPtr->serializeMessageInContext(object, metaObject);
+
+    context.stage = QProtobufSerializerPrivate::SerializationContext::Writing;
+    context.device = device;
+    context.buffer = QByteArray(QProtobufSerializerPrivate::OutputChunkSize, Qt::Uninitialized);
+    context.out = context.buffer.data();
+    context.end = context.out + context.buffer.size();
+    dPtr->serializeMessageInContext(object, metaObject);
+    context.flush();
+    Q_ASSERT_X(context.cursor == context.sizes.size(), "QProtobufSerializer", "Serialized size mismatch");
+    return !context.failed;
+}
+
+int QProtobufSerializer::serializedMessageSize(const QObject *object, const QProtobufMetaObject &metaObject) const
+{
+    //Only sizing pass of serializeMessage() is performed. Sizes of nested messages are not needed
+    //for writing, so they are not stored and nothing is allocated
+    QProtobufSerializerPrivate::SerializationContext context(dPtr.get());
+    context.measuring = true;
+    QScopedValueRollback<QProtobufSerializerPrivate::SerializationContext *> scope(QProtobufSerializerPrivate::context, &context);
+    dPtr->serializeMessageInContext(object, metaObject);
+    return context.size;
+}
+
+QByteArray QProtobufSerializer::serializeMaskedMessage(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufFieldMask &mask) const
+{
+    if (!mask.isValid()) {
+        return QByteArray();
     }
+    return dPtr->serializeMessage(object, metaObject, mask.selectsAll() ? nullptr : &mask);
+}
 
-    return result;
+QAbstractProtobufSerializer::DeserializationError QProtobufSerializer::deserializationError() const
+{
+    return QProtobufSerializerPrivate::deserializationError;
+}
+
+QString QProtobufSerializer::deserializationErrorString() const
+{
+    return QString::fromLatin1(QProtobufSerializerPrivate::deserializationErrorString);
+}
+
+bool QProtobufSerializer::deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+{
+    QProtobufSerializerPrivate::resetDeserializationError();
+    QScopedValueRollback<Options> scope(QProtobufSerializerPrivate::deserializationOptions, dPtr->options);
+    QScopedValueRollback<bool> mergeScope(QProtobufSerializerPrivate::merging, false);
+    QScopedValueRollback<const QByteArray *> inputScope(QProtobufSerializerPrivate::input, &data);
+    if (metaObject.unknownFields != nullptr) {
+        metaObject.unknownFields(object)->clear();
+    }
+    QProtobufSelfcheckIterator it(data);
+    dPtr->deserializeMessage(object, metaObject, it);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
+}
+
+bool QProtobufSerializer::mergeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+{
+    QProtobufSerializerPrivate::resetDeserializationError();
+    QScopedValueRollback<Options> scope(QProtobufSerializerPrivate::deserializationOptions, dPtr->options);
+    QScopedValueRollback<bool> mergeScope(QProtobufSerializerPrivate::merging, true);
+    QScopedValueRollback<const QByteArray *> inputScope(QProtobufSerializerPrivate::input, &data);
+    QProtobufSelfcheckIterator it(data);
+    dPtr->deserializeMessage(object, metaObject, it);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
+}
+
+bool QProtobufSerializer::deserializeMessageInto(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+{
+    QProtobufSerializerPrivate::resetDeserializationError();
+    QScopedValueRollback<Options> scope(QProtobufSerializerPrivate::deserializationOptions, dPtr->options);
+    QScopedValueRollback<bool> mergeScope(QProtobufSerializerPrivate::merging, true);
+    QScopedValueRollback<const QByteArray *> inputScope(QProtobufSerializerPrivate::input, &data);
+    QProtobufSelfcheckIterator it(data);
+    dPtr->deserializeMessage(object, metaObject, it, true);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
 }
 
-void QProtobufSerializer::deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const
+bool QProtobufSerializer::deserializeMaskedMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data,
+                                                   const QProtobufFieldMask &mask) const
 {
-    for (QProtobufSelfcheckIterator it(data); it != data.end();) {
-        dPtr->deserializeProperty(object, metaObject, it);
+    QProtobufSerializerPrivate::resetDeserializationError();
+    QScopedValueRollback<Options> scope(QProtobufSerializerPrivate::deserializationOptions, dPtr->options);
+    QScopedValueRollback<bool> mergeScope(QProtobufSerializerPrivate::merging, false);
+    QScopedValueRollback<const QByteArray *> inputScope(QProtobufSerializerPrivate::input, &data);
+    if (!mask.isValid()) {
+        QProtobufSerializerPrivate::setDeserializationError(InvalidFormatError, "Field mask is invalid");
+        return false;
+    }
+    QScopedValueRollback<const QProtobufFieldMask *> maskScope(QProtobufSerializerPrivate::fieldMask, mask.selectsAll() ? nullptr : &mask);
+    if (metaObject.unknownFields != nullptr) {
+        metaObject.unknownFields(object)->clear();
     }
+    QProtobufSelfcheckIterator it(data);
+    dPtr->deserializeMessage(object, metaObject, it);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
 }
 
 QByteArray QProtobufSerializer::serializeObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const
 {
+    if (dPtr->activeContext() != nullptr) {
+        dPtr->serializeLengthDelimitedInContext(metaProperty.protoFieldIndex(), [&] {
+            dPtr->serializeMessageInContext(object, metaObject);
+        });
+        return QByteArray();
+    }
+
     QByteArray result = QProtobufSerializerPrivate::encodeHeader(metaProperty.protoFieldIndex(), LengthDelimited);
     result.append(QProtobufSerializerPrivate::prependLengthDelimitedSize(serializeMessage(object, metaObject)));
     return result;
 }
 
-void QProtobufSerializer::deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
+bool QProtobufSerializer::deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
 {
-    QByteArray array = QProtobufSerializerPrivate::deserializeLengthDelimited(it);
-    deserializeMessage(object, metaObject, array);
+    //Nested message is deserialized in place, using iterator bounded by message size
+    QProtobufSelfcheckIterator messageIt = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(it);
+    if (QProtobufSerializerPrivate::hasDeserializationError()) {
+        return false;
+    }
+    dPtr->deserializeMessage(object, metaObject, messageIt);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
 }
 
 QByteArray QProtobufSerializer::serializeListObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const
@@ -123,12 +247,19 @@ QByteArray QProtobufSerializer::serializeListObject(const QObject *object, const
 
 bool QProtobufSerializer::deserializeListObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const
 {
-    deserializeObject(object, metaObject, it);
-    return true;
+    return deserializeObject(object, metaObject, it);
 }
 
 QByteArray QProtobufSerializer::serializeMapPair(const QVariant &key, const QVariant &value, const QProtobufMetaProperty &metaProperty) const
 {
+    if (dPtr->activeContext() != nullptr) {
+        dPtr->serializeLengthDelimitedInContext(metaProperty.protoFieldIndex(), [&] {
+            dPtr->serializePropertyInContext(key, QProtobufMetaProperty(metaProperty, 1, QString()));
+            dPtr->serializePropertyInContext(value, QProtobufMetaProperty(metaProperty, 2, QString()));
+        });
+        return QByteArray();
+    }
+
     QByteArray result = QProtobufSerializerPrivate::encodeHeader(metaProperty.protoFieldIndex(), LengthDelimited);
     result.append(QProtobufSerializerPrivate::prependLengthDelimitedSize(
                       dPtr->serializeProperty(key, QProtobufMetaProperty(metaProperty, 1, QString())) +
@@ -138,12 +269,16 @@ QByteArray QProtobufSerializer::serializeMapPair(const QVariant &key, const QVar
 
 bool QProtobufSerializer::deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it) const
 {
-    dPtr->deserializeMapPair(key, value, it);
-    return true;
+    return dPtr->deserializeMapPair(key, value, it);
 }
 
 QByteArray QProtobufSerializer::serializeEnum(int64 value, const QMetaEnum &/*metaEnum*/, const QtProtobuf::QProtobufMetaProperty &metaProperty) const
 {
+    if (dPtr->activeContext() != nullptr) {
+        dPtr->serializeFieldInContext(value, metaProperty.protoFieldIndex(), Varint);
+        return QByteArray();
+    }
+
     WireTypes type = Varint;
     int fieldIndex = metaProperty.protoFieldIndex();
     QByteArray result = QProtobufSerializerPrivate::serializeBasic<int64>(value, fieldIndex);
@@ -155,6 +290,11 @@ QByteArray QProtobufSerializer::serializeEnum(int64 value, const QMetaEnum &/*me
 
 QByteArray QProtobufSerializer::serializeEnumList(const QList<int64> &value, const QMetaEnum &/*metaEnum*/, const QtProtobuf::QProtobufMetaProperty &metaProperty) const
 {
+    if (dPtr->activeContext() != nullptr) {
+        dPtr->serializeFieldInContext(value, metaProperty.protoFieldIndex(), LengthDelimited);
+        return QByteArray();
+    }
+
     WireTypes type = LengthDelimited;
     int fieldIndex = metaProperty.protoFieldIndex();
     QByteArray result = QProtobufSerializerPrivate::serializeListType<int64>(value, fieldIndex);
@@ -164,70 +304,73 @@ QByteArray QProtobufSerializer::serializeEnumList(const QList<int64> &value, con
     return result;
 }
 
-void QProtobufSerializer::deserializeEnum(int64 &value, const QMetaEnum &/*metaEnum*/, QProtobufSelfcheckIterator &it) const
+bool QProtobufSerializer::deserializeEnum(int64 &value, const QMetaEnum &/*metaEnum*/, QProtobufSelfcheckIterator &it) const
 {
-    QVariant variantValue;
-    QProtobufSerializerPrivate::deserializeBasic<int64>(it, variantValue);
-    value = variantValue.value<int64>();
+    value = QProtobufSerializerPrivate::deserializeValue<int64>(it);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
 }
 
-void QProtobufSerializer::deserializeEnumList(QList<int64> &value, const QMetaEnum &/*metaEnum*/, QProtobufSelfcheckIterator &it) const
+bool QProtobufSerializer::deserializeEnumList(QList<int64> &value, const QMetaEnum &/*metaEnum*/, QProtobufSelfcheckIterator &it) const
 {
     QVariant variantValue;
     QProtobufSerializerPrivate::deserializeList<int64>(it, variantValue);
     value = variantValue.value<QList<int64>>();
+    return !QProtobufSerializerPrivate::hasDeserializationError();
 }
 
-QProtobufSerializerPrivate::QProtobufSerializerPrivate(QProtobufSerializer *q) : q_ptr(q)
-{
-    //if handlers is not empty intialization already done
-    if (handlers.empty()) {
-        wrapSerializer<float, serializeBasic, deserializeBasic<float>, Fixed32>();
-        wrapSerializer<double, serializeBasic, deserializeBasic<double>, Fixed64>();
-        wrapSerializer<int32, serializeBasic, deserializeBasic<int32>, Varint>();
-        wrapSerializer<int64, serializeBasic, deserializeBasic<int64>, Varint>();
-        wrapSerializer<uint32, serializeBasic, deserializeBasic<uint32>, Varint>();
-        wrapSerializer<uint64, serializeBasic, deserializeBasic<uint64>, Varint>();
-        wrapSerializer<sint32, serializeBasic, deserializeBasic<sint32>, Varint>();
-        wrapSerializer<sint64, serializeBasic, deserializeBasic<sint64>, Varint>();
-        wrapSerializer<fixed32, serializeBasic, deserializeBasic<fixed32>, Fixed32>();
-        wrapSerializer<fixed64, serializeBasic, deserializeBasic<fixed64>, Fixed64>();
-        wrapSerializer<sfixed32, serializeBasic, deserializeBasic<sfixed32>, Fixed32>();
-        wrapSerializer<sfixed64, serializeBasic, deserializeBasic<sfixed64>, Fixed64>();
-        wrapSerializer<bool, uint32, serializeBasic<uint32>, deserializeBasic<uint32>, Varint>();
-        wrapSerializer<QString, serializeBasic, deserializeBasic<QString>, LengthDelimited>();
-        wrapSerializer<QByteArray, serializeBasic, deserializeBasic<QByteArray>, LengthDelimited>();
-
-        wrapSerializer<FloatList, serializeListType, deserializeList<float>, LengthDelimited>();
-        wrapSerializer<DoubleList, serializeListType, deserializeList<double>, LengthDelimited>();
-        wrapSerializer<fixed32List, serializeListType, deserializeList<fixed32>, LengthDelimited>();
-        wrapSerializer<fixed64List, serializeListType, deserializeList<fixed64>, LengthDelimited>();
-        wrapSerializer<sfixed32List, serializeListType, deserializeList<sfixed32>, LengthDelimited>();
-        wrapSerializer<sfixed64List, serializeListType, deserializeList<sfixed64>, LengthDelimited>();
-        wrapSerializer<int32List, serializeListType, deserializeList<int32>, LengthDelimited>();
-        wrapSerializer<int64List, serializeListType, deserializeList<int64>, LengthDelimited>();
-        wrapSerializer<sint32List, serializeListType, deserializeList<sint32>, LengthDelimited>();
-        wrapSerializer<sint64List, serializeListType, deserializeList<sint64>, LengthDelimited>();
-        wrapSerializer<uint32List, serializeListType, deserializeList<uint32>, LengthDelimited>();
-        wrapSerializer<uint64List, serializeListType, deserializeList<uint64>, LengthDelimited>();
-        wrapSerializer<QStringList, QStringList, serializeListType<QString>, deserializeList<QString>, LengthDelimited>();
-        wrapSerializer<QByteArrayList, serializeListType, deserializeList<QByteArray>, LengthDelimited>();
-    }
+QProtobufSerializerPrivate::QProtobufSerializerPrivate(QProtobufSerializer *q) : options(QProtobufSerializer::NoOptions)
+  , q_ptr(q)
+{
+}
+
+const QProtobufSerializerPrivate::SerializerRegistry &QProtobufSerializerPrivate::handlers()
+{
+    //Table is built once on first use and only read afterwards, so it's safe to use from any thread
+    static const SerializerRegistry registry = [] {
+        SerializerRegistry basicHandlers;
+        wrapSerializer<float, serializeBasic, deserializeBasic<float>, Fixed32>(basicHandlers);
+        wrapSerializer<double, serializeBasic, deserializeBasic<double>, Fixed64>(basicHandlers);
+        wrapSerializer<int32, serializeBasic, deserializeBasic<int32>, Varint>(basicHandlers);
+        wrapSerializer<int64, serializeBasic, deserializeBasic<int64>, Varint>(basicHandlers);
+        wrapSerializer<uint32, serializeBasic, deserializeBasic<uint32>, Varint>(basicHandlers);
+        wrapSerializer<uint64, serializeBasic, deserializeBasic<uint64>, Varint>(basicHandlers);
+        wrapSerializer<sint32, serializeBasic, deserializeBasic<sint32>, Varint>(basicHandlers);
+        wrapSerializer<sint64, serializeBasic, deserializeBasic<sint64>, Varint>(basicHandlers);
+        wrapSerializer<fixed32, serializeBasic, deserializeBasic<fixed32>, Fixed32>(basicHandlers);
+        wrapSerializer<fixed64, serializeBasic, deserializeBasic<fixed64>, Fixed64>(basicHandlers);
+        wrapSerializer<sfixed32, serializeBasic, deserializeBasic<sfixed32>, Fixed32>(basicHandlers);
+        wrapSerializer<sfixed64, serializeBasic, deserializeBasic<sfixed64>, Fixed64>(basicHandlers);
+        wrapSerializer<bool, uint32, serializeBasic<uint32>, deserializeBasic<uint32>, Varint>(basicHandlers);
+        wrapSerializer<QString, serializeBasic, deserializeBasic<QString>, LengthDelimited>(basicHandlers);
+        wrapSerializer<QByteArray, serializeBasic, deserializeBasic<QByteArray>, LengthDelimited>(basicHandlers);
+
+        wrapSerializer<FloatList, serializeListType, deserializeList<float>, LengthDelimited>(basicHandlers);
+        wrapSerializer<DoubleList, serializeListType, deserializeList<double>, LengthDelimited>(basicHandlers);
+        wrapSerializer<fixed32List, serializeListType, deserializeList<fixed32>, LengthDelimited>(basicHandlers);
+        wrapSerializer<fixed64List, serializeListType, deserializeList<fixed64>, LengthDelimited>(basicHandlers);
+        wrapSerializer<sfixed32List, serializeListType, deserializeList<sfixed32>, LengthDelimited>(basicHandlers);
+        wrapSerializer<sfixed64List, serializeListType, deserializeList<sfixed64>, LengthDelimited>(basicHandlers);
+        wrapSerializer<int32List, serializeListType, deserializeList<int32>, LengthDelimited>(basicHandlers);
+        wrapSerializer<int64List, serializeListType, deserializeList<int64>, LengthDelimited>(basicHandlers);
+        wrapSerializer<sint32List, serializeListType, deserializeList<sint32>, LengthDelimited>(basicHandlers);
+        wrapSerializer<sint64List, serializeListType, deserializeList<sint64>, LengthDelimited>(basicHandlers);
+        wrapSerializer<uint32List, serializeListType, deserializeList<uint32>, LengthDelimited>(basicHandlers);
+        wrapSerializer<uint64List, serializeListType, deserializeList<uint64>, LengthDelimited>(basicHandlers);
+        wrapSerializer<QStringList, QStringList, serializeListType<QString>, deserializeList<QString>, LengthDelimited>(basicHandlers);
+        wrapSerializer<QByteArrayList, serializeListType, deserializeList<QByteArray>, LengthDelimited>(basicHandlers);
+        return basicHandlers;
+    }();
+    return registry;
 }
 
 void QProtobufSerializerPrivate::skipVarint(QProtobufSelfcheckIterator &it)
 {
-    while ((*it) & 0x80) {
-        ++it;
-    }
-    ++it;
+    deserializeVarintCommon<uint64>(it);
 }
 
 void QProtobufSerializerPrivate::skipLengthDelimited(QProtobufSelfcheckIterator &it)
 {
-    //Get length of lenght-delimited field
-    uint32 length = QProtobufSerializerPrivate::deserializeVarintCommon<uint32>(it);
-    it += length;
+    deserializeLengthDelimitedRange(it);
 }
 
 int QProtobufSerializerPrivate::skipSerializedFieldBytes(QProtobufSelfcheckIterator &it, WireTypes type)
@@ -238,17 +381,20 @@ int QProtobufSerializerPrivate::skipSerializedFieldBytes(QProtobufSelfcheckItera
         skipVarint(it);
         break;
     case WireTypes::Fixed32:
-        it += sizeof(decltype(fixed32::_t));
+        deserializeValue<fixed32>(it);
         break;
     case WireTypes::Fixed64:
-        it += sizeof(decltype(fixed64::_t));
+        deserializeValue<fixed64>(it);
         break;
     case WireTypes::LengthDelimited:
         skipLengthDelimited(it);
         break;
     case WireTypes::UnknownWireType:
     default:
-        throw std::invalid_argument("Cannot skip due to undefined length of the redundant field.");
+        setDeserializationError(QAbstractProtobufSerializer::InvalidHeaderError,
+                                "Cannot skip due to undefined length of the redundant field.");
+        it += it.size();
+        break;
     }
 
     return std::distance(initialIt, QByteArray::const_iterator(it));
@@ -267,91 +413,701 @@ QByteArray QProtobufSerializerPrivate::serializeProperty(const QVariant &propert
 
     //TODO: replace with some common function
     int fieldIndex = metaProperty.protoFieldIndex();
-    auto basicIt = handlers.find(userType);
-    if (basicIt != handlers.end()) {
-        type = basicIt->second.type;
-        result.append(basicIt->second.serializer(propertyValue, fieldIndex));
+    auto basicHandlers = basicHandler(userType);
+    if (basicHandlers != nullptr) {
+        type = basicHandlers->type;
+        result.append(basicHandlers->serializer(propertyValue, fieldIndex));
         if (fieldIndex != QtProtobufPrivate::NotUsedFieldIndex
                 && type != UnknownWireType) {
             result.prepend(QProtobufSerializerPrivate::encodeHeader(metaProperty.protoFieldIndex(), type));
         }
     } else {
-        auto handler = QtProtobufPrivate::findHandler(userType);
-        handler.serializer(q_ptr, propertyValue, metaProperty, result);
+        auto handler = registeredHandler(userType);
+        if (handler != nullptr) {
+            handler->serializer(q_ptr, propertyValue, metaProperty, result);
+        }
     }
     return result;
 }
 
+QByteArray QProtobufSerializerPrivate::serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject,
+                                                       const QProtobufFieldMask *mask)
+{
+    //Message is serialized in two passes: first pass calculates and caches sizes of all fields
+    //and nested messages, second pass writes message to preallocated buffer at once. Fields that are
+    //not selected by mask are skipped at both passes
+    SerializationContext context(this);
+    context.mask = mask;
+    QScopedValueRollback<SerializationContext *> scope(QProtobufSerializerPrivate::context, &context);
+    serializeMessageInContext(object, metaObject);
+
+    QByteArray result(context.size, Qt::Uninitialized);
+    context.stage = SerializationContext::Writing;
+    context.out = result.data();
+    serializeMessageInContext(object, metaObject);
+    Q_ASSERT_X(context.out == result.data() + result.size(), "QProtobufSerializer", "Serialized size mismatch");
+    Q_ASSERT_X(context.cursor == context.sizes.size(), "QProtobufSerializer", "Serialized size mismatch");
+    return result;
+}
+
+void QProtobufSerializerPrivate::serializeMessageInContext(const QObject *object, const QProtobufMetaObject &metaObject)
+{
+    if (context->mask != nullptr) {
+        serializeMaskedMessageInContext(object, metaObject);
+        return;
+    }
+
+    if (metaObject.typedSerializer != nullptr) {
+        QProtobufTypedWriter writer(this, object, metaObject);
+        metaObject.typedSerializer(object, writer);
+    } else {
+        for (const auto &field : metaObject.fields()) {
+            serializeFieldInContext(field.metaProperty.read(object), field);
+        }
+    }
+
+    //Unknown fields are written back as is after known fields
+    if (metaObject.unknownFields != nullptr) {
+        const QProtobufUnknownFields *unknownFields = metaObject.unknownFields(const_cast<QObject *>(object));
+        if (context->stage == SerializationContext::Sizing) {
+            context->size += unknownFields->size();
+        } else {
+            context->reserve(unknownFields->size());
+            context->out = options.testFlag(QProtobufSerializer::Deterministic) ? unknownFields->writeOrdered(context->out)
+                                                                                : unknownFields->write(context->out);
+        }
+    }
+}
+
+void QProtobufSerializerPrivate::serializeMaskedMessageInContext(const QObject *object, const QProtobufMetaObject &metaObject)
+{
+    //Unknown fields are not selected by mask, so they are not written
+    const QProtobufFieldMask *mask = context->mask;
+    for (const auto &field : metaObject.fields()) {
+        const QProtobufFieldMask *subMask = nullptr;
+        if (!mask->select(field.metaProperty.protoFieldIndex(), subMask)) {
+            continue;
+        }
+        QScopedValueRollback<const QProtobufFieldMask *> scope(context->mask, subMask);
+        serializeFieldInContext(field.metaProperty.read(object), field);
+    }
+}
+
+void QProtobufSerializerPrivate::serializePropertyInContext(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty,
+                                                            const QtProtobufPrivate::SerializationHandler *handler)
+{
+    qProtoDebug() << __func__ << "propertyValue" << propertyValue << "fieldIndex" << metaProperty.protoFieldIndex()
+                  << static_cast<QMetaType::Type>(propertyValue.type());
+
+    int userType = propertyValue.userType();
+    auto basicHandlers = basicHandler(userType);
+    if (basicHandlers != nullptr) {
+        if (context->stage == SerializationContext::Sizing) {
+            context->size += basicHandlers->sizer(propertyValue, metaProperty.protoFieldIndex());
+        } else {
+            if (context->device != nullptr) {
+                context->reserve(basicHandlers->sizer(propertyValue, metaProperty.protoFieldIndex()));
+            }
+            basicHandlers->writer(propertyValue, metaProperty.protoFieldIndex(), context->out);
+        }
+    } else {
+        //Nested messages, lists, maps and enums are serialized using registered handlers, that call
+        //serializer virtual methods aware of active context. Result buffer stays empty.
+        QByteArray unused;
+        if (handler == nullptr) {
+            handler = registeredHandler(userType);
+            if (handler == nullptr) {
+                return;
+            }
+        }
+        handler->serializer(q_ptr, propertyValue, metaProperty, unused);
+        Q_ASSERT(unused.isEmpty());
+    }
+}
+
+void QProtobufSerializerPrivate::serializeFieldInContext(const QVariant &propertyValue, const QProtobufFieldInfo &field)
+{
+    //Handler cached in field descriptor is only valid if value type matches property type
+    serializePropertyInContext(propertyValue, field.metaProperty,
+                               propertyValue.userType() == field.userType ? field.handler : nullptr);
+}
+
+bool QProtobufSerializerPrivate::decodeFieldHeader(QProtobufSelfcheckIterator &it, int &fieldIndex, WireTypes &wireType)
+{
+    if (!QProtobufSerializerPrivate::decodeHeader(it, fieldIndex, wireType)) {
+        setDeserializationError(QAbstractProtobufSerializer::InvalidHeaderError,
+                                "Message received doesn't contains valid header byte. Seems stream is broken");
+        it += it.size();
+        return false;
+    }
+    return true;
+}
+
 void QProtobufSerializerPrivate::deserializeProperty(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it)
 {
     //Each iteration we expect iterator is setup to beginning of next chunk
     int fieldNumber = QtProtobufPrivate::NotUsedFieldIndex;
     WireTypes wireType = UnknownWireType;
-    if (!QProtobufSerializerPrivate::decodeHeader(it, fieldNumber, wireType)) {
-        qProtoCritical() << "Message received doesn't contains valid header byte. "
-                            "Trying next, but seems stream is broken" << QString::number((*it), 16);
-        throw std::invalid_argument("Message received doesn't contains valid header byte. "
-                              "Seems stream is broken");
-    }
-
-    auto propertyNumberIt = metaObject.propertyOrdering.find(fieldNumber);
-    if (propertyNumberIt == std::end(metaObject.propertyOrdering)) {
-        auto bytesCount = QProtobufSerializerPrivate::skipSerializedFieldBytes(it, wireType);
-        qProtoWarning() << "Message received contains unexpected/optional field. WireType:" << wireType
-                        << ", field number: " << fieldNumber << "Skipped:" << (bytesCount + 1) << "bytes";
+    const char *fieldBegin = it.data();
+    if (!decodeFieldHeader(it, fieldNumber, wireType)) {
+        return;
+    }
+    deserializeField(object, metaObject, fieldNumber, wireType, it, fieldBegin);
+}
+
+void QProtobufSerializerPrivate::deserializeField(QObject *object, const QProtobufMetaObject &metaObject, int fieldNumber, WireTypes wireType,
+                                                  QProtobufSelfcheckIterator &it, const char *fieldBegin)
+{
+    //Fields that are not selected by mask are skipped without construction of values
+    const QProtobufFieldMask *subMask = nullptr;
+    if (fieldMask != nullptr && !fieldMask->select(fieldNumber, subMask)) {
+        skipSerializedFieldBytes(it, wireType);
         return;
     }
 
-    int propertyIndex = propertyNumberIt->second;
-    QMetaProperty metaProperty = metaObject.staticMetaObject.property(propertyIndex);
+    const QProtobufFieldInfo *field = metaObject.field(fieldNumber);
+    if (field == nullptr) {
+        deserializeUnknownField(object, metaObject, fieldNumber, wireType, it, fieldBegin);
+        return;
+    }
+
+    if (notificationBatch != nullptr) {
+        notificationBatch->touch(field);
+    }
+
+    const QProtobufMetaProperty &metaProperty = field->metaProperty;
 
     qProtoDebug() << __func__ << " wireType: " << wireType << " metaProperty: " << metaProperty.typeName()
                   << "currentByte:" << QString::number((*it), 16);
 
+    int userType = field->userType;
+
+    //TODO: replace with some common function
+    auto basicHandlers = basicHandler(userType);
+    const QtProtobufPrivate::SerializationHandler *handler = nullptr;
+    bool repeated = false;
+    if (basicHandlers != nullptr) {
+        repeated = basicHandlers->repeated;
+    } else {
+        handler = field->handler;
+        if (handler == nullptr) {
+            handler = registeredHandler(userType);
+            if (handler == nullptr) {
+                setDeserializationError(QAbstractProtobufSerializer::NoDeserializerError,
+                                        "No serialization handler registered for type");
+                it += it.size();
+                return;
+            }
+        }
+        repeated = handler->type != QtProtobufPrivate::ObjectHandler;
+    }
+
+    //Nested messages are deserialized using sub-mask of field
+    QScopedValueRollback<const QProtobufFieldMask *> maskScope(fieldMask, subMask);
+
+    //Elements of repeated fields are accumulated by builder and written to object once message is deserialized
+    if (repeated && repeatedFieldsBuilder != nullptr) {
+        QVariant &accumulatedValue = repeatedFieldsBuilder->value(field);
+        if (basicHandlers != nullptr) {
+            basicHandlers->deserializer(it, accumulatedValue);
+        } else {
+            handler->deserializer(q_ptr, it, accumulatedValue);
+        }
+        checkIterator(it);
+        return;
+    }
+
     QVariant newPropertyValue;
     newPropertyValue = metaProperty.read(object);
-    int userType = metaProperty.userType();
 
-    //TODO: replace with some common function
-    auto basicIt = handlers.find(userType);
-    if (basicIt != handlers.end()) {
-        basicIt->second.deserializer(it, newPropertyValue);
+    if (basicHandlers != nullptr) {
+        basicHandlers->deserializer(it, newPropertyValue);
+    } else if (merging && handler->merger) {
+        handler->merger(q_ptr, it, newPropertyValue);
     } else {
-        auto handler = QtProtobufPrivate::findHandler(userType);
-        handler.deserializer(q_ptr, it, newPropertyValue);
+        handler->deserializer(q_ptr, it, newPropertyValue);
     }
 
+    if (!checkIterator(it) || hasDeserializationError()) {
+        return;
+    }
     metaProperty.write(object, newPropertyValue);
 }
 
-void QProtobufSerializerPrivate::deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it)
+void QProtobufSerializerPrivate::deserializeUnknownField(QObject *object, const QProtobufMetaObject &metaObject, int fieldNumber, WireTypes wireType,
+                                                         QProtobufSelfcheckIterator &it, const char *fieldBegin)
+{
+    skipSerializedFieldBytes(it, wireType);
+    if (hasDeserializationError()) {
+        return;
+    }
+
+    //Unknown fields are counted per message type, only first one is reported
+    if (metaObject.countUnknownField()) {
+        qProtoWarning() << "Message" << metaObject.staticMetaObject.className() << "received contains unexpected/optional field."
+                        << "WireType:" << wireType << ", field number: " << fieldNumber
+                        << ". Further unexpected fields of this message type are counted silently";
+    }
+
+    if (metaObject.unknownFields == nullptr) {
+        return;
+    }
+
+    int size = static_cast<int>(it.data() - fieldBegin);
+    QProtobufUnknownFields *unknownFields = metaObject.unknownFields(object);
+    if (input != nullptr && fieldBegin >= input->constData() && it.data() <= input->constData() + input->size()) {
+        unknownFields->append(*input, static_cast<int>(fieldBegin - input->constData()), size);
+    } else {
+        unknownFields->append(QByteArray(fieldBegin, size), 0, size);
+    }
+}
+
+void QProtobufSerializerPrivate::deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it, bool clear)
+{
+    if (!deserializationOptions.testFlag(QProtobufSerializer::BatchedNotify)) {
+        if (clear) {
+            QAbstractProtobufSerializer::clearMessage(object, metaObject);
+        }
+        deserializeMessageFields(object, metaObject, it);
+        return;
+    }
+
+    NotificationBatch batch(object, metaObject);
+    QScopedValueRollback<NotificationBatch *> scope(notificationBatch, &batch);
+    if (clear) {
+        QAbstractProtobufSerializer::clearMessage(object, metaObject);
+        batch.touchAll();
+    }
+    deserializeMessageFields(object, metaObject, it);
+}
+
+void QProtobufSerializerPrivate::deserializeMessageFields(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it)
+{
+    RepeatedFieldsBuilder builder(object);
+    QScopedValueRollback<RepeatedFieldsBuilder *> scope(repeatedFieldsBuilder, &builder);
+    if (metaObject.typedDeserializer != nullptr && fieldMask == nullptr) {
+        QProtobufTypedReader reader(this, object, metaObject, it);
+        metaObject.typedDeserializer(object, reader);
+    } else {
+        while (it.size() > 0 && !hasDeserializationError()) {
+            deserializeProperty(object, metaObject, it);
+        }
+    }
+    checkIterator(it);
+}
+
+bool QProtobufSerializerPrivate::mergeFields(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data, int size)
+{
+    //Stream chunks are released when next chunk is fed, so bytes fields are always copied
+    QProtobufSerializer::Options mergeOptions = options;
+    mergeOptions.setFlag(QProtobufSerializer::RawDataBytes, false);
+    QScopedValueRollback<QProtobufSerializer::Options> scope(deserializationOptions, mergeOptions);
+    QScopedValueRollback<bool> mergeScope(merging, true);
+    QScopedValueRollback<const QByteArray *> inputScope(input, &data);
+    resetDeserializationError();
+    QProtobufSelfcheckIterator range = QProtobufSelfcheckIterator(data).subRange(size);
+    deserializeMessage(object, metaObject, range);
+    return !hasDeserializationError();
+}
+
+void QProtobufSerializerPrivate::SerializationContext::flush(int bytes)
+{
+    int buffered = static_cast<int>(out - buffer.constData());
+    if (buffered > 0 && !failed) {
+        failed = device->write(buffer.constData(), buffered) != buffered;
+    }
+
+    if (buffer.size() < bytes) {
+        buffer.resize(bytes);
+    }
+    out = buffer.data();
+    end = out + buffer.size();
+}
+
+QProtobufSerializerPrivate::NotificationBatch::NotificationBatch(QObject *_object, const QProtobufMetaObject &_metaObject) : object(_object)
+  , metaObject(_metaObject)
+  , touched(_metaObject.fields().size(), false)
+  , wasBlocked(_object->blockSignals(true))
+  , updated(false)
+{
+}
+
+QProtobufSerializerPrivate::NotificationBatch::~NotificationBatch()
+{
+    object->blockSignals(wasBlocked);
+    if (wasBlocked || !updated) {
+        return;
+    }
+
+    const auto &fields = metaObject.fields();
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (touched[i] && fields[i].metaProperty.hasNotifySignal()) {
+            fields[i].metaProperty.notifySignal().invoke(object, Qt::DirectConnection);
+        }
+    }
+
+    const QMetaObject *objectMetaObject = object->metaObject();
+    int updatedSignalIndex = objectMetaObject->indexOfSignal("messageUpdated()");
+    if (updatedSignalIndex >= 0) {
+        objectMetaObject->method(updatedSignalIndex).invoke(object, Qt::DirectConnection);
+    }
+}
+
+void QProtobufSerializerPrivate::NotificationBatch::touch(const QProtobufFieldInfo *field)
+{
+    if (field == nullptr) {
+        return;
+    }
+    touched[static_cast<size_t>(field - metaObject.fields().data())] = true;
+    updated = true;
+}
+
+void QProtobufSerializerPrivate::NotificationBatch::touchAll()
+{
+    std::fill(touched.begin(), touched.end(), true);
+    updated = !touched.empty();
+}
+
+QProtobufSerializerPrivate::RepeatedFieldsBuilder::~RepeatedFieldsBuilder()
+{
+    //Partially accumulated values are discarded if deserialization failed, so corrupt input doesn't
+    //leave repeated fields of object mutated
+    if (hasDeserializationError()) {
+        return;
+    }
+
+    for (auto &value : values) {
+        value.first->metaProperty.write(object, value.second);
+    }
+}
+
+QVariant &QProtobufSerializerPrivate::RepeatedFieldsBuilder::value(const QProtobufFieldInfo *field)
+{
+    //Elements of repeated field usually go one by one, so last accumulated field is checked first
+    if (!values.empty() && values.back().first == field) {
+        return values.back().second;
+    }
+
+    auto it = std::find_if(values.begin(), values.end(), [field](const std::pair<const QProtobufFieldInfo *, QVariant> &value) {
+        return value.first == field;
+    });
+    if (it != values.end()) {
+        return it->second;
+    }
+
+    values.emplace_back(field, field->metaProperty.read(object));
+    return values.back().second;
+}
+
+bool QProtobufSerializerPrivate::deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it)
 {
     int mapIndex = 0;
     WireTypes type = WireTypes::UnknownWireType;
-    unsigned int count = QProtobufSerializerPrivate::deserializeVarintCommon<uint32>(it);
-    qProtoDebug() << __func__ << "count:" << count;
-    QProtobufSelfcheckIterator last = it + count;
-    while (it != last) {
-        QProtobufSerializerPrivate::decodeHeader(it, mapIndex, type);
+    QProtobufSelfcheckIterator pairIt = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(it);
+    qProtoDebug() << __func__ << "count:" << pairIt.size();
+    while (pairIt.size() > 0 && !hasDeserializationError()) {
+        QProtobufSerializerPrivate::decodeHeader(pairIt, mapIndex, type);
         if (mapIndex == 1) {
             //Only simple types are supported as keys
             int userType = key.userType();
-            auto &handler = handlers.at(userType);//throws if not found
-            handler.deserializer(it, key);
+            auto keyHandlers = basicHandler(userType);
+            if (keyHandlers == nullptr) {
+                setDeserializationError(QAbstractProtobufSerializer::NoDeserializerError, "Map key type is not supported");
+                break;
+            }
+            keyHandlers->deserializer(pairIt, key);
         } else {
             //TODO: replace with some common function
             int userType = value.userType();
-            auto basicIt = handlers.find(userType);
-            if (basicIt != handlers.end()) {
-                basicIt->second.deserializer(it, value);
+            auto basicHandlers = basicHandler(userType);
+            auto handler = basicHandlers == nullptr ? registeredHandler(userType) : nullptr;
+            if (basicHandlers != nullptr) {
+                basicHandlers->deserializer(pairIt, value);
+            } else if (handler != nullptr) {
+                handler->deserializer(q_ptr, pairIt, value);
             } else {
-                auto handler = QtProtobufPrivate::findHandler(userType);
-                handler.deserializer(q_ptr, it, value);//throws if not implemented
+                setDeserializationError(QAbstractProtobufSerializer::NoDeserializerError,
+                                        "No serialization handler registered for type");
             }
         }
     }
+    return !hasDeserializationError();
 }
 
-QProtobufSerializerPrivate::SerializerRegistry QProtobufSerializerPrivate::handlers = {};
+namespace {
+template <typename T>
+bool isNullValue(const T &)
+{
+    return false;
+}
+
+//Null strings and byte arrays are skipped same as null QVariant at reflective path
+bool isNullValue(const QString &value)
+{
+    return value.isNull();
+}
+
+bool isNullValue(const QByteArray &value)
+{
+    return value.isNull();
+}
+
+template <typename T>
+void readValue(QProtobufSelfcheckIterator &it, T &value)
+{
+    T result = QProtobufSerializerPrivate::deserializeValue<T>(it);
+    if (!QProtobufSerializerPrivate::hasDeserializationError()) {
+        value = result;
+    }
+}
+
+template <typename V>
+void readValue(QProtobufSelfcheckIterator &it, QList<V> &value)
+{
+    QProtobufSelfcheckIterator range = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(it);
+    QList<V> out;
+    if (QProtobufSerializerPrivate::hasDeserializationError()
+            || !QProtobufSerializerPrivate::checkDecodeStatus(QProtobufSerializerPrivate::decodePackedList<V>(range.data(), range.data() + range.size(), out))) {
+        return;
+    }
+    if (QProtobufSerializerPrivate::merging) {
+        value.append(out);
+    } else {
+        value = out;
+    }
+}
+
+void readValue(QProtobufSelfcheckIterator &it, QString &value)
+{
+    QProtobufSelfcheckIterator data = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(it);
+    if (!QProtobufSerializerPrivate::hasDeserializationError()) {
+        value = QString::fromUtf8(data.data(), data.size());
+    }
+}
+
+void readValue(QProtobufSelfcheckIterator &it, QByteArray &value)
+{
+    QByteArray result = QProtobufSerializerPrivate::deserializeLengthDelimited(it);
+    if (!QProtobufSerializerPrivate::hasDeserializationError()) {
+        value = result;
+    }
+}
+
+void readValue(QProtobufSelfcheckIterator &it, QStringList &value)
+{
+    QString element;
+    readValue(it, element);
+    if (!QProtobufSerializerPrivate::hasDeserializationError()) {
+        value.append(element);
+    }
+}
+
+void readValue(QProtobufSelfcheckIterator &it, QByteArrayList &value)
+{
+    QByteArray element;
+    readValue(it, element);
+    if (!QProtobufSerializerPrivate::hasDeserializationError()) {
+        value.append(element);
+    }
+}
+}
+
+QProtobufTypedWriter::QProtobufTypedWriter(QProtobufSerializerPrivate *serializer, const QObject *object, const QProtobufMetaObject &metaObject) : m_serializer(serializer)
+  , m_object(object)
+  , m_metaObject(metaObject)
+{
+}
+
+template <typename T>
+void QProtobufTypedWriter::write(int fieldNumber, const T &value)
+{
+    if (isNullValue(value)) {
+        return;
+    }
+    m_serializer->serializeFieldInContext(value, fieldNumber, WireTypeOf<T>::value);
+}
+
+void QProtobufTypedWriter::writeEnum(int fieldNumber, int64 value)
+{
+    m_serializer->serializeFieldInContext(value, fieldNumber, Varint);
+}
+
+void QProtobufTypedWriter::writeMessage(int fieldNumber, const QObject *object, const QProtobufMetaObject &metaObject)
+{
+    m_serializer->serializeLengthDelimitedInContext(fieldNumber, [&] {
+        m_serializer->serializeMessageInContext(object, metaObject);
+    });
+}
+
+bool QProtobufTypedWriter::keepsSerializedMessages() const
+{
+    return !m_serializer->options.testFlag(QProtobufSerializer::Deterministic);
+}
+
+void QProtobufTypedWriter::writeSerializedMessage(int fieldNumber, const QByteArray &data)
+{
+    m_serializer->serializeFieldInContext(data, fieldNumber, LengthDelimited);
+}
+
+void QProtobufTypedWriter::writeProperty(int fieldNumber)
+{
+    const QProtobufFieldInfo *field = m_metaObject.field(fieldNumber);
+    Q_ASSERT_X(field != nullptr, "QProtobufTypedWriter", "Field is not part of message");
+    m_serializer->serializeFieldInContext(field->metaProperty.read(m_object), *field);
+}
+
+QProtobufTypedReader::QProtobufTypedReader(QProtobufSerializerPrivate *serializer, QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) : m_serializer(serializer)
+  , m_object(object)
+  , m_metaObject(metaObject)
+  , m_it(it)
+  , m_fieldNumber(QtProtobufPrivate::NotUsedFieldIndex)
+  , m_wireType(UnknownWireType)
+  , m_fieldBegin(nullptr)
+{
+}
+
+QProtobufTypedReader::~QProtobufTypedReader()
+{
+    for (auto field : m_changedFields) {
+        field->metaProperty.notifySignal().invoke(m_object, Qt::DirectConnection);
+    }
+}
+
+bool QProtobufTypedReader::next()
+{
+    if (m_it.size() <= 0 || QProtobufSerializerPrivate::hasDeserializationError()) {
+        return false;
+    }
+    m_fieldBegin = m_it.data();
+    if (!QProtobufSerializerPrivate::decodeFieldHeader(m_it, m_fieldNumber, m_wireType)) {
+        return false;
+    }
+    if (QProtobufSerializerPrivate::notificationBatch != nullptr) {
+        QProtobufSerializerPrivate::notificationBatch->touch(m_metaObject.field(m_fieldNumber));
+    }
+    return true;
+}
+
+template <typename T>
+void QProtobufTypedReader::read(T &value)
+{
+    readValue(m_it, value);
+}
+
+int64 QProtobufTypedReader::readEnum()
+{
+    return QProtobufSerializerPrivate::deserializeValue<int64>(m_it);
+}
+
+bool QProtobufTypedReader::readMessage(QObject *object, const QProtobufMetaObject &metaObject)
+{
+    QProtobufSelfcheckIterator messageIt = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(m_it);
+    if (QProtobufSerializerPrivate::hasDeserializationError()) {
+        return false;
+    }
+    m_serializer->deserializeMessage(object, metaObject, messageIt);
+    return !QProtobufSerializerPrivate::hasDeserializationError();
+}
+
+bool QProtobufTypedReader::isMerging() const
+{
+    return QProtobufSerializerPrivate::merging;
+}
+
+bool QProtobufTypedReader::isLazy() const
+{
+    return QProtobufSerializerPrivate::deserializationOptions.testFlag(QProtobufSerializer::LazyMessages);
+}
+
+int QProtobufTypedReader::options() const
+{
+    return static_cast<int>(QProtobufSerializerPrivate::deserializationOptions);
+}
+
+QByteArray QProtobufTypedReader::readSerializedMessage()
+{
+    QProtobufSelfcheckIterator messageIt = QProtobufSerializerPrivate::deserializeLengthDelimitedRange(m_it);
+    //Data is copied, since lazy message may outlive input buffer
+    return QByteArray(messageIt.data(), messageIt.size());
+}
+
+void QProtobufTypedReader::readProperty()
+{
+    m_serializer->deserializeField(m_object, m_metaObject, m_fieldNumber, m_wireType, m_it, m_fieldBegin);
+}
+
+void QProtobufTypedReader::notifyChanged()
+{
+    const QProtobufFieldInfo *field = m_metaObject.field(m_fieldNumber);
+    if (field == nullptr || !field->metaProperty.hasNotifySignal()
+            || std::find(m_changedFields.begin(), m_changedFields.end(), field) != m_changedFields.end()) {
+        return;
+    }
+    m_changedFields.push_back(field);
+}
+
+#define Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(T)\
+    template void QProtobufTypedWriter::write<T>(int, const T &);\
+    template void QProtobufTypedReader::read<T>(T &);
+
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(float)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(double)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(int32)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(int64)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(uint32)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(uint64)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sint32)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sint64)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(fixed32)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(fixed64)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sfixed32)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sfixed64)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(bool)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(QString)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(QByteArray)
+
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(FloatList)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(DoubleList)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(int32List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(int64List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(uint32List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(uint64List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sint32List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sint64List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(fixed32List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(fixed64List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sfixed32List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(sfixed64List)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(QStringList)
+Q_PROTOBUF_TYPED_SERIALIZER_INSTANTIATE(QByteArrayList)
+
+thread_local QProtobufSerializerPrivate::SerializationContext *QProtobufSerializerPrivate::context = nullptr;
+thread_local QProtobufSerializer::Options QProtobufSerializerPrivate::deserializationOptions = QProtobufSerializer::NoOptions;
+thread_local bool QProtobufSerializerPrivate::merging = false;
+thread_local QProtobufSerializerPrivate::NotificationBatch *QProtobufSerializerPrivate::notificationBatch = nullptr;
+thread_local QProtobufSerializerPrivate::RepeatedFieldsBuilder *QProtobufSerializerPrivate::repeatedFieldsBuilder = nullptr;
+thread_local const QByteArray *QProtobufSerializerPrivate::input = nullptr;
+thread_local const QProtobufFieldMask *QProtobufSerializerPrivate::fieldMask = nullptr;
+thread_local QAbstractProtobufSerializer::DeserializationError QProtobufSerializerPrivate::deserializationError = QAbstractProtobufSerializer::NoError;
+thread_local const char *QProtobufSerializerPrivate::deserializationErrorString = nullptr;
+
+}
+
+bool QtProtobufPrivate::deserializeLazyMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QByteArray &data,
+                                               int options)
+{
+    //Nested messages of lazy message stay lazy as well. Lazy data is released once message is deserialized,
+    //so bytes fields can't refer it and RawDataBytes is not applied
+    QtProtobuf::QProtobufSerializer::Options lazyOptions = QFlag(options);
+    lazyOptions.setFlag(QtProtobuf::QProtobufSerializer::LazyMessages);
+    lazyOptions.setFlag(QtProtobuf::QProtobufSerializer::RawDataBytes, false);
+    QtProtobuf::QProtobufSerializer serializer(lazyOptions);
+    const QtProtobuf::QAbstractProtobufSerializer &abstractSerializer = serializer;
+    if (abstractSerializer.deserializeMessage(object, metaObject, data)) {
+        return true;
+    }
 
+    //Partially deserialized message is not exposed, error stays available in current thread
+    QtProtobuf::QAbstractProtobufSerializer::clearMessage(object, metaObject);
+    return false;
 }
@@ -34,19 +34,63 @@ class QProtobufSerializerPrivate;
 /*!
  * \ingroup QtProtobuf
  * \brief The QProtobufSerializer class
+ *
+ * \details Serializer is thread-safe: single instance may be used from several threads concurrently, as long
+ *          as options are not changed. State of serialization in progress is kept per thread.
  */
 class Q_PROTOBUF_EXPORT QProtobufSerializer : public QAbstractProtobufSerializer
 {
 public:
-    QProtobufSerializer();
+    /*!
+     * \brief The Option enum describes serializer options
+     */
+    enum Option {
+        NoOptions = 0x00, /*!< Default behavior */
+        RawDataBytes = 0x01, /*!< bytes fields are deserialized as slices of input buffer without copying,
+                                  see QByteArray::fromRawData(). Input buffer must outlive deserialized
+                                  messages and must not be modified */
+        BatchedNotify = 0x02, /*!< change notifications are held back while message is deserialized. Afterwards
+                                  notify signal of each deserialized property is emitted once, followed by
+                                  messageUpdated() signal if message class declares it */
+        LazyMessages = 0x04, /*!< nested messages are kept serialized by generated typed deserializers and
+                                 decoded on first access. Messages that were not accessed are serialized
+                                 back as is */
+        Deterministic = 0x08 /*!< equal messages are serialized to equal bytes. Fields are always written in
+                                  order of field numbers and map entries in order of keys, additionally nested
+                                  messages kept serialized are re-encoded and unknown fields are written in
+                                  order of field numbers */
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
+    QProtobufSerializer(Options options = NoOptions);
     ~QProtobufSerializer();
 
+    /*!
+     * \brief Returns serializer options
+     */
+    Options options() const;
+
+    /*!
+     * \brief Sets serializer \a options. Options should not be changed while serializer is in use
+     */
+    void setOptions(Options options);
+
+    DeserializationError deserializationError() const override;
+    QString deserializationErrorString() const override;
+
 protected:
     QByteArray serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject) const override;
-    void deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool serializeMessageTo(const QObject *object, const QProtobufMetaObject &metaObject, QIODevice *device) const override;
+    int serializedMessageSize(const QObject *object, const QProtobufMetaObject &metaObject) const override;
+    QByteArray serializeMaskedMessage(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufFieldMask &mask) const override;
+    bool deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool mergeMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool deserializeMessageInto(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool deserializeMaskedMessage(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data,
+                                  const QProtobufFieldMask &mask) const override;
 
     QByteArray serializeObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const override;
-    void deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const override;
 
     QByteArray serializeListObject(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufMetaProperty &metaProperty) const override;
     bool deserializeListObject(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it) const override;
@@ -57,10 +101,15 @@ protected:
     QByteArray serializeEnum(int64 value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
     QByteArray serializeEnumList(const QList<int64> &value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
 
-    void deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
-    void deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnum(int64 &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnumList(QList<int64> &value, const QMetaEnum &metaEnum, QProtobufSelfcheckIterator &it) const override;
 
     std::unique_ptr<QProtobufSerializerPrivate> dPtr;
+
+private:
+    friend class QProtobufStreamParser;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(QProtobufSerializer::Options)
+
 }
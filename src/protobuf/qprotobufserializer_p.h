@@ -24,21 +24,73 @@
  */
 
 #include <QString>
+#include <QStringList>
 #include <QByteArray>
+#include <QtAlgorithms>
+
+#include <vector>
+#include <cstring>
 
 #include "qprotobufselfcheckiterator.h"
 #include "qtprotobuftypes.h"
 #include "qtprotobuflogging.h"
 #include "qabstractprotobufserializer.h"
+#include "qprotobufserializer.h"
+#include "qprotobuftypedserializer.h"
+#include "qprotobufmetaobject.h"
 
 namespace QtProtobuf {
 
+//! \private
+template <typename V>
+struct IsList : std::false_type {};
+
+//! \private
+template <typename V>
+struct IsList<QList<V>> : std::true_type {};
+
+//! \private
+template <>
+struct IsList<QStringList> : std::true_type {};
+
+//! \private
+template <typename V>
+struct IsVarint : std::integral_constant<bool, std::is_integral<V>::value
+                                               || std::is_same<V, int32>::value
+                                               || std::is_same<V, int64>::value> {};
+
+//! \private
+template <typename V>
+struct IsFixed : std::integral_constant<bool, std::is_floating_point<V>::value
+                                              || std::is_same<V, fixed32>::value
+                                              || std::is_same<V, fixed64>::value
+                                              || std::is_same<V, sfixed32>::value
+                                              || std::is_same<V, sfixed64>::value> {};
+
+/*!
+ * \private
+ * \brief QList keeps elements of movable types that are not larger than pointer in place. If element
+ *        size is equal to pointer size, elements are laid out in memory as plain array
+ */
+template <typename V>
+struct IsPlainArrayInList : std::integral_constant<bool, !QTypeInfo<V>::isStatic
+                                                         && !QTypeInfo<V>::isLarge
+                                                         && sizeof(V) == sizeof(void *)> {};
+
+/*!
+ * \private
+ * \brief Statically known wire type of field of type \a V
+ */
+template <typename V>
+struct WireTypeOf : std::integral_constant<WireTypes, IsVarint<V>::value ? Varint
+                                                      : !IsFixed<V>::value ? LengthDelimited
+                                                      : sizeof(V) == 4 ? Fixed32 : Fixed64> {};
+
 /*!
  * \ingroup QtProtobuf
  * \private
  * \brief The QProtobufSerializerPrivate class
  */
-class QProtobufSerializer;
 //! \private
 class QProtobufSerializerPrivate final
 {
@@ -53,6 +105,15 @@ public:
      * \brief Deserializer is interface function for deserialize method
      */
     using Deserializer = void(*)(QProtobufSelfcheckIterator &, QVariant &);
+    /*!
+     * \brief Sizer is interface function that calculates size of serialized field including its header.
+     *        Returns 0 if field will not be serialized
+     */
+    using Sizer = int(*)(const QVariant &, int);
+    /*!
+     * \brief Writer is interface function that writes serialized field including its header to preallocated buffer
+     */
+    using Writer = void(*)(const QVariant &, int, char *&);
 
     /*!
      * \private
@@ -62,9 +123,125 @@ public:
         Serializer serializer; /*!< serializer assigned to class */
         Deserializer deserializer;/*!< deserializer assigned to class */
         WireTypes type;/*!< Serialization WireType */
+        Sizer sizer;/*!< sizer assigned to class */
+        Writer writer;/*!< writer assigned to class */
+        bool repeated;/*!< true if values are accumulated by repeated fields builder */
+    };
+
+    /*!
+     * \private
+     * \brief SerializationContext keeps state of two-pass serialization
+     *
+     * \details At Sizing stage sizes of length-delimited messages and map pairs are collected in order of
+     *          appearance. At Writing stage they are consumed in the same order, so each size prefix
+     *          is written directly to preallocated buffer before nested message content.
+     */
+    struct SerializationContext {
+        enum Stage {
+            Sizing,
+            Writing
+        };
+
+        SerializationContext(const QProtobufSerializerPrivate *_owner) : owner(_owner)
+          , stage(Sizing)
+          , cursor(0)
+          , size(0)
+          , out(nullptr)
+          , end(nullptr)
+          , device(nullptr)
+          , failed(false)
+          , measuring(false)
+          , mask(nullptr) {}
+
+        /*!
+         * \brief Makes \a bytes available at out position. If message is written to device, buffered data is flushed
+         *        when buffer is full. Buffer grows only if single field is bigger than buffer.
+         */
+        void reserve(int bytes) {
+            if (device != nullptr && end - out < bytes) {
+                flush(bytes);
+            }
+        }
+        void flush(int bytes = 0);
+
+        const QProtobufSerializerPrivate *owner;
+        Stage stage;
+        std::vector<int> sizes;
+        size_t cursor;
+        int size;
+        char *out;
+        char *end;
+        QIODevice *device;//nullptr if message is written to preallocated buffer
+        QByteArray buffer;//Chunk buffer used when message is written to device
+        bool failed;//Writing to device failed
+        bool measuring;//Only total size is calculated, sizes of nested messages are not stored for Writing stage
+        const QProtobufFieldMask *mask;//Mask of fields of message that is serialized at the moment, nullptr if all fields are serialized
+    };
+
+    //! \private
+    static constexpr int OutputChunkSize = 64 * 1024;
+
+    /*!
+     * \private
+     * \brief NotificationBatch holds back change notifications of message while it's deserialized
+     *
+     * \details Signals of object are blocked while its fields are populated. When batch is destroyed, notify
+     *          signal of each written property is emitted once, followed by messageUpdated() signal if
+     *          object declares it.
+     */
+    struct NotificationBatch {
+        NotificationBatch(QObject *object, const QProtobufMetaObject &metaObject);
+        ~NotificationBatch();
+        Q_DISABLE_COPY(NotificationBatch)
+
+        void touch(const QProtobufFieldInfo *field);
+        void touchAll();
+
+        QObject *object;
+        const QProtobufMetaObject &metaObject;
+        std::vector<bool> touched;
+        bool wasBlocked;
+        bool updated;
+    };
+
+    /*!
+     * \private
+     * \brief RepeatedFieldsBuilder accumulates values of repeated and map fields of message while it's deserialized
+     *
+     * \details Each field is read from object once and elements are appended to accumulated value in place.
+     *          Accumulated values are written back to object once, when builder is destroyed, so parsing of
+     *          field with N elements takes linear time. If deserialization failed, accumulated values are
+     *          discarded and repeated fields of object are left unchanged.
+     */
+    struct RepeatedFieldsBuilder {
+        RepeatedFieldsBuilder(QObject *object) : object(object) {}
+        ~RepeatedFieldsBuilder();
+        Q_DISABLE_COPY(RepeatedFieldsBuilder)
+
+        QVariant &value(const QProtobufFieldInfo *field);
+
+        QObject *object;
+        std::vector<std::pair<const QProtobufFieldInfo *, QVariant>> values;
+    };
+
+    /*!
+     * \private
+     * \brief SerializerRegistry is flat table of basic type handlers indexed by metatype identifier.
+     *        Slots of types without handler have nullptr serializer
+     */
+    using SerializerRegistry = std::vector<SerializationHandlers>;
+
+    /*!
+     * \brief The DecodeStatus enum describes result of raw buffer decoding
+     */
+    enum DecodeStatus {
+        DecodeOk, /*!< Value is decoded successfully */
+        DecodeTruncated, /*!< Buffer is shorter than required to decode value */
+        DecodeMalformedVarint /*!< Varint value is longer than MaxVarintSize bytes */
     };
 
-    using SerializerRegistry = std::unordered_map<int/*metatypeid*/, SerializationHandlers>;
+    //! \private
+    static constexpr int MaxVarintSize = 10;
 
     QProtobufSerializerPrivate(QProtobufSerializer *q);
     ~QProtobufSerializerPrivate() = default;
@@ -270,85 +447,657 @@ public:
     }
 
     //###########################################################################
-    //                               Deserializers
+    //                          Two-pass serializers
     //###########################################################################
+    /*!
+     * \brief Calculates size of varint from position of highest set bit, without loop over 7-bit groups
+     */
+    static int varintSize(quint64 value) {
+        return ((63 - static_cast<int>(qCountLeadingZeroBits(value | 1))) * 9 + 73) / 64;
+    }
+
+    static void writeVarint(quint64 value, char *&out) {
+        while (value >= 0b10000000) {
+            //Put 7 bits to output buffer and mark as "not last" (0b10000000)
+            *out++ = static_cast<char>((value & 0b01111111) | 0b10000000);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+    }
+
+    static int headerSize(int fieldIndex) {
+        return varintSize(static_cast<quint32>(fieldIndex) << 3);
+    }
+
+    static void writeHeader(int fieldIndex, WireTypes wireType, char *&out) {
+        writeVarint((static_cast<quint32>(fieldIndex) << 3) | wireType, out);
+    }
+
+    /*!
+     * \brief Calculates size of UTF-8 representation of \a value
+     *
+     * \details Follows QString::toUtf8 conversion rules: surrogate pair takes 4 bytes,
+     *          unpaired surrogate is replaced with '?'
+     */
+    static int utf8Size(const QString &value) {
+        int size = 0;
+        const QChar *it = value.constData();
+        const QChar *end = it + value.size();
+        for (; it != end; ++it) {
+            ushort c = it->unicode();
+            if (c < 0x80) {
+                size += 1;
+            } else if (c < 0x800) {
+                size += 2;
+            } else if (!QChar::isSurrogate(c)) {
+                size += 3;
+            } else if (QChar::isHighSurrogate(c) && (it + 1) != end && (it + 1)->isLowSurrogate()) {
+                size += 4;
+                ++it;
+            } else {
+                size += 1;
+            }
+        }
+        return size;
+    }
+
+    static void writeUtf8(const QString &value, char *&out) {
+        const QChar *it = value.constData();
+        const QChar *end = it + value.size();
+        for (; it != end; ++it) {
+            ushort c = it->unicode();
+            if (c < 0x80) {
+                *out++ = static_cast<char>(c);
+            } else if (c < 0x800) {
+                *out++ = static_cast<char>(0xc0 | (c >> 6));
+                *out++ = static_cast<char>(0x80 | (c & 0x3f));
+            } else if (!QChar::isSurrogate(c)) {
+                *out++ = static_cast<char>(0xe0 | (c >> 12));
+                *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+                *out++ = static_cast<char>(0x80 | (c & 0x3f));
+            } else if (QChar::isHighSurrogate(c) && (it + 1) != end && (it + 1)->isLowSurrogate()) {
+                uint ucs4 = QChar::surrogateToUcs4(c, (it + 1)->unicode());
+                *out++ = static_cast<char>(0xf0 | (ucs4 >> 18));
+                *out++ = static_cast<char>(0x80 | ((ucs4 >> 12) & 0x3f));
+                *out++ = static_cast<char>(0x80 | ((ucs4 >> 6) & 0x3f));
+                *out++ = static_cast<char>(0x80 | (ucs4 & 0x3f));
+                ++it;
+            } else {
+                *out++ = '?';
+            }
+        }
+    }
+
+    template <typename V>
+    static bool isDefaultValue(const V &value, std::true_type /*isVarint*/) {
+        return value == 0;
+    }
+
+    template <typename V>
+    static bool isDefaultValue(const V &/*value*/, std::false_type /*isVarint*/) {
+        return false;
+    }
+
+    //---------------Integral and floating point types sizers/writers------------
+    template <typename V,
+              typename std::enable_if_t<std::is_floating_point<V>::value
+                                        || std::is_same<V, fixed32>::value
+                                        || std::is_same<V, fixed64>::value
+                                        || std::is_same<V, sfixed32>::value
+                                        || std::is_same<V, sfixed64>::value, int> = 0>
+    static int sizeBasic(const V &) {
+        return sizeof(V);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_floating_point<V>::value
+                                        || std::is_same<V, fixed32>::value
+                                        || std::is_same<V, fixed64>::value
+                                        || std::is_same<V, sfixed32>::value
+                                        || std::is_same<V, sfixed64>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        memcpy(out, &value, sizeof(V));
+        out += sizeof(V);
+    }
+
     template <typename V,
               typename std::enable_if_t<std::is_integral<V>::value
                                         && std::is_unsigned<V>::value, int> = 0>
-    static V deserializeVarintCommon(QProtobufSelfcheckIterator &it) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
+    static int sizeBasic(const V &value) {
+        return varintSize(static_cast<quint64>(value));
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_integral<V>::value
+                                        && std::is_unsigned<V>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        writeVarint(static_cast<quint64>(value), out);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_integral<V>::value
+                                        && std::is_signed<V>::value, int> = 0>
+    static int sizeBasic(const V &value) {
+        using UV = typename std::make_unsigned<V>::type;
+        return sizeBasic(static_cast<UV>((value << 1) ^ (value >> (sizeof(UV) * 8 - 1))));
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_integral<V>::value
+                                        && std::is_signed<V>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        using UV = typename std::make_unsigned<V>::type;
+        writeBasic(static_cast<UV>((value << 1) ^ (value >> (sizeof(UV) * 8 - 1))), out);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, int32>::value
+                                        || std::is_same<V, int64>::value, int> = 0>
+    static int sizeBasic(const V &value) {
+        using UV = typename std::make_unsigned<V>::type;
+        return sizeBasic(static_cast<UV>(value));
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, int32>::value
+                                        || std::is_same<V, int64>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        using UV = typename std::make_unsigned<V>::type;
+        writeBasic(static_cast<UV>(value), out);
+    }
+
+    //------------------QString and QByteArray types sizers/writers--------------
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QString>::value, int> = 0>
+    static int sizeBasic(const V &value) {
+        int size = utf8Size(value);
+        return varintSize(size) + size;
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QString>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        writeVarint(utf8Size(value), out);
+        writeUtf8(value, out);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QByteArray>::value, int> = 0>
+    static int sizeBasic(const V &value) {
+        return varintSize(value.size()) + value.size();
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QByteArray>::value, int> = 0>
+    static void writeBasic(const V &value, char *&out) {
+        writeVarint(value.size(), out);
+        memcpy(out, value.constData(), value.size());
+        out += value.size();
+    }
+
+    //--------------------------Field sizers/writers-----------------------------
+    /*!
+     * \brief Calculates size of field with index \a fieldIndex including its header
+     *
+     * \details Follows the same rules as serializeBasic: zero varint values are not serialized
+     * \return Size of serialized field or 0 if field will not be serialized
+     */
+    template <typename V,
+              typename std::enable_if_t<!IsList<V>::value, int> = 0>
+    static int sizeField(const V &value, int fieldIndex) {
+        if (isDefaultValue(value, IsVarint<V>())) {
+            return 0;
+        }
+        return headerSize(fieldIndex) + sizeBasic<V>(value);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<!IsList<V>::value, int> = 0>
+    static void writeField(const V &value, int fieldIndex, WireTypes type, char *&out) {
+        if (isDefaultValue(value, IsVarint<V>())) {
+            return;
+        }
+        writeHeader(fieldIndex, type, out);
+        writeBasic<V>(value, out);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<IsVarint<V>::value, int> = 0>
+    static int sizePackedList(const QList<V> &listValue) {
+        int size = 0;
+        for (auto &value : listValue) {
+            size += sizeBasic<V>(value);
+        }
+        return size;
+    }
+
+    template <typename V,
+              typename std::enable_if_t<IsFixed<V>::value, int> = 0>
+    static int sizePackedList(const QList<V> &listValue) {
+        return listValue.count() * static_cast<int>(sizeof(V));
+    }
+
+    template <typename V,
+              typename std::enable_if_t<IsVarint<V>::value, int> = 0>
+    static void writePackedList(const QList<V> &listValue, char *&out) {
+        for (auto &value : listValue) {
+            writeBasic<V>(value, out);
+        }
+    }
+
+    /*!
+     * \brief Writes packed list of fixed-width values
+     *
+     * \details Packed fixed-width values are stored in the same layout as in memory, so in case if
+     *          list keeps elements as plain array, list is copied at once
+     */
+    template <typename V,
+              typename std::enable_if_t<IsFixed<V>::value, int> = 0>
+    static void writePackedList(const QList<V> &listValue, char *&out) {
+        if (IsPlainArrayInList<V>::value && !listValue.isEmpty()) {
+            int size = listValue.count() * static_cast<int>(sizeof(V));
+            memcpy(out, &listValue.at(0), size);
+            out += size;
+            return;
+        }
+
+        for (auto &value : listValue) {
+            memcpy(out, &value, sizeof(V));
+            out += sizeof(V);
+        }
+    }
+
+    /*!
+     * \brief Calculates size of packed list including its header and length prefix
+     *
+     * \return Size of serialized list or 0 if list is empty
+     */
+    template <typename V,
+              typename std::enable_if_t<!(std::is_same<V, QString>::value
+                                        || std::is_same<V, QByteArray>::value), int> = 0>
+    static int sizeField(const QList<V> &listValue, int fieldIndex) {
+        if (listValue.isEmpty()) {
+            return 0;
+        }
+        int size = sizePackedList(listValue);
+        return headerSize(fieldIndex) + varintSize(size) + size;
+    }
+
+    template <typename V,
+              typename std::enable_if_t<!(std::is_same<V, QString>::value
+                                        || std::is_same<V, QByteArray>::value), int> = 0>
+    static void writeField(const QList<V> &listValue, int fieldIndex, WireTypes /*type*/, char *&out) {
+        if (listValue.isEmpty()) {
+            return;
+        }
+        writeHeader(fieldIndex, LengthDelimited, out);
+        writeSizedPackedList(listValue, out);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<IsFixed<V>::value, int> = 0>
+    static void writeSizedPackedList(const QList<V> &listValue, char *&out) {
+        writeVarint(sizePackedList(listValue), out);
+        writePackedList(listValue, out);
+    }
+
+    /*!
+     * \brief Writes length prefix and packed list of varints in single pass over list
+     *
+     * \details Elements are written assuming one byte length prefix. Output buffer is sized for the actual
+     *          prefix, so if list is longer than 127 bytes, written elements are moved to make room for it
+     */
+    template <typename V,
+              typename std::enable_if_t<IsVarint<V>::value, int> = 0>
+    static void writeSizedPackedList(const QList<V> &listValue, char *&out) {
+        char *payload = out + 1;
+        char *payloadEnd = payload;
+        writePackedList(listValue, payloadEnd);
+        int size = static_cast<int>(payloadEnd - payload);
+        int prefixSize = varintSize(size);
+        if (prefixSize > 1) {
+            memmove(payload + prefixSize - 1, payload, size);
+        }
+        writeVarint(size, out);
+        out += size;
+    }
+
+    /*!
+     * \brief Calculates size of non-packed list of strings or byte arrays, each element has own header
+     *
+     * \return Size of serialized list or 0 if list is empty
+     */
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QString>::value
+                                        || std::is_same<V, QByteArray>::value, int> = 0>
+    static int sizeField(const QList<V> &listValue, int fieldIndex) {
+        int size = 0;
+        for (auto &value : listValue) {
+            size += sizeBasic<V>(value);
+        }
+        return size + listValue.count() * headerSize(fieldIndex);
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_same<V, QString>::value
+                                        || std::is_same<V, QByteArray>::value, int> = 0>
+    static void writeField(const QList<V> &listValue, int fieldIndex, WireTypes /*type*/, char *&out) {
+        for (auto &value : listValue) {
+            writeHeader(fieldIndex, LengthDelimited, out);
+            writeBasic<V>(value, out);
+        }
+    }
+
+    template <typename T>
+    static int sizeWrapper(const QVariant &variantValue, int fieldIndex) {
+        if (variantValue.isNull()) {
+            return 0;
+        }
+        return sizeField(*(static_cast<const T *>(variantValue.data())), fieldIndex);
+    }
+
+    template <typename T, WireTypes type>
+    static void writeWrapper(const QVariant &variantValue, int fieldIndex, char *&out) {
+        if (variantValue.isNull()) {
+            return;
+        }
+        writeField(*(static_cast<const T *>(variantValue.data())), fieldIndex, type, out);
+    }
+
+    //###########################################################################
+    //                               Deserializers
+    //###########################################################################
+    /*!
+     * \brief Decodes varint from [\a it, \a end) range and moves \a it behind decoded value
+     *
+     * \details In case if at least MaxVarintSize bytes left in range, varint is decoded without
+     *          bounds checks
+     * \return DecodeOk if value is decoded, or error status otherwise. \a it is not moved in case of error
+     */
+    static DecodeStatus decodeVarint(const char *&it, const char *end, quint64 &value) {
+        const uchar *data = reinterpret_cast<const uchar *>(it);
+        if (end - it >= MaxVarintSize) {
+            quint64 result = data[0];
+            if (result < 0b10000000) {
+                value = result;
+                ++it;
+                return DecodeOk;
+            }
 
-        V value = 0;
-        int k = 0;
-        while (true) {
-            uint64_t byte = static_cast<uint64_t>(*it);
-            value += (byte & 0b01111111) << k;
-            k += 7;
-            if (((*it) & 0b10000000) == 0) {
-                break;
+            result &= 0b01111111;
+            for (int i = 1; i < MaxVarintSize; i++) {
+                quint64 byte = data[i];
+                result |= (byte & 0b01111111) << (7 * i);
+                if (byte < 0b10000000) {
+                    value = result;
+                    it += i + 1;
+                    return DecodeOk;
+                }
             }
-            ++it;
+            return DecodeMalformedVarint;
         }
-        ++it;
-        return value;
+
+        quint64 result = 0;
+        int available = static_cast<int>(end - it);
+        for (int i = 0; i < available; i++) {
+            quint64 byte = data[i];
+            result |= (byte & 0b01111111) << (7 * i);
+            if (byte < 0b10000000) {
+                value = result;
+                it += i + 1;
+                return DecodeOk;
+            }
+        }
+        return DecodeTruncated;
     }
 
-    //-------------Integral and floating point types deserializers---------------
+    //-------------Integral and floating point types decoders--------------------
     template <typename V,
               typename std::enable_if_t<std::is_floating_point<V>::value
                                         || std::is_same<V, fixed32>::value
                                         || std::is_same<V, fixed64>::value
                                         || std::is_same<V, sfixed32>::value
                                         || std::is_same<V, sfixed64>::value, int> = 0>
-    static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
-
-        variantValue = QVariant::fromValue(*(V *)((QByteArray::const_iterator&)it));
+    static DecodeStatus decodeBasic(const char *&it, const char *end, V &value) {
+        if (end - it < static_cast<int>(sizeof(V))) {
+            return DecodeTruncated;
+        }
+        memcpy(&value, it, sizeof(V));
         it += sizeof(V);
+        return DecodeOk;
     }
 
     template <typename V,
               typename std::enable_if_t<std::is_integral<V>::value
                                         && std::is_unsigned<V>::value, int> = 0>
-    static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
-
-        variantValue = QVariant::fromValue(deserializeVarintCommon<V>(it));
+    static V fromVarint(quint64 varint) {
+        return static_cast<V>(varint);
     }
 
     template <typename V,
               typename std::enable_if_t<std::is_integral<V>::value
-                                        && std::is_signed<V>::value,int> = 0>
-    static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
+                                        && std::is_signed<V>::value, int> = 0>
+    static V fromVarint(quint64 varint) {
         using  UV = typename std::make_unsigned<V>::type;
-        UV unsignedValue = deserializeVarintCommon<UV>(it);
-        V value = (unsignedValue >> 1) ^ (-1 * (unsignedValue & 1));
-        variantValue = QVariant::fromValue<V>(value);
+        UV unsignedValue = static_cast<UV>(varint);
+        return (unsignedValue >> 1) ^ (-1 * (unsignedValue & 1));
     }
 
     template <typename V,
               typename std::enable_if_t<std::is_same<int32, V>::value
                                         || std::is_same<int64, V>::value, int> = 0>
-    static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
+    static V fromVarint(quint64 varint) {
         using  UV = typename std::make_unsigned<V>::type;
-        UV unsignedValue = deserializeVarintCommon<UV>(it);
-        V value = static_cast<V>(unsignedValue);
-        variantValue = QVariant::fromValue(value);
+        return static_cast<V>(static_cast<UV>(varint));
+    }
+
+    template <typename V,
+              typename std::enable_if_t<IsVarint<V>::value, int> = 0>
+    static DecodeStatus decodeBasic(const char *&it, const char *end, V &value) {
+        quint64 varint = 0;
+        DecodeStatus status = decodeVarint(it, end, varint);
+        value = fromVarint<V>(varint);
+        return status;
+    }
+
+    //-------------------------Packed list decoders------------------------------
+    /*!
+     * \brief Counts varints in [\a it, \a end) range, processing 8 bytes at once
+     */
+    static int countVarints(const char *it, const char *end) {
+        int count = 0;
+        for (; end - it >= 8; it += 8) {
+            quint64 word;
+            memcpy(&word, it, sizeof(word));
+            count += qPopulationCount(~word & 0x8080808080808080ULL);
+        }
+        for (; it != end; ++it) {
+            if ((*it & 0b10000000) == 0) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /*!
+     * \brief Decodes packed list of varints from [\a it, \a end) range
+     *
+     * \details Amount of elements is counted in advance, to allocate list once. Runs of 8 single-byte
+     *          varints are detected using single 64-bit load and decoded without branching per byte
+     */
+    template <typename V,
+              typename std::enable_if_t<IsVarint<V>::value, int> = 0>
+    static DecodeStatus decodePackedList(const char *it, const char *end, QList<V> &out) {
+        out.reserve(out.count() + countVarints(it, end));
+        while (it != end) {
+            if (end - it >= 8) {
+                quint64 word;
+                memcpy(&word, it, sizeof(word));
+                if ((word & 0x8080808080808080ULL) == 0) {
+                    const uchar *data = reinterpret_cast<const uchar *>(it);
+                    for (int i = 0; i < 8; i++) {
+                        out.append(fromVarint<V>(data[i]));
+                    }
+                    it += 8;
+                    continue;
+                }
+            }
+
+            V value;
+            DecodeStatus status = decodeBasic<V>(it, end, value);
+            if (status != DecodeOk) {
+                return status;
+            }
+            out.append(value);
+        }
+        return DecodeOk;
+    }
+
+    /*!
+     * \brief Decodes packed list of fixed-width values from [\a it, \a end) range
+     *
+     * \details Size of range is validated once. In case if list keeps elements as plain array, list is
+     *          presized and whole range is copied at once, otherwise elements are loaded without
+     *          further bounds checks
+     */
+    template <typename V,
+              typename std::enable_if_t<IsFixed<V>::value, int> = 0>
+    static DecodeStatus decodePackedList(const char *it, const char *end, QList<V> &out) {
+        if ((end - it) % sizeof(V) != 0) {
+            return DecodeTruncated;
+        }
+
+        int count = static_cast<int>((end - it) / sizeof(V));
+        if (count == 0) {
+            return DecodeOk;
+        }
+
+        int first = out.count();
+        out.reserve(first + count);
+        if (IsPlainArrayInList<V>::value) {
+            //Qt5 QList has no resize(), list is grown by default values that are overwritten at once
+            for (int i = 0; i < count; i++) {
+                out.append(V());
+            }
+            memcpy(&out[first], it, count * sizeof(V));
+            return DecodeOk;
+        }
+
+        for (int i = 0; i < count; i++) {
+            V value;
+            memcpy(&value, it, sizeof(V));
+            out.append(value);
+            it += sizeof(V);
+        }
+        return DecodeOk;
+    }
+
+    /*!
+     * \brief Records first deserialization \a error of current thread. Deserialization is not interrupted,
+     *        but loops over fields stop as soon as error is recorded
+     */
+    static void setDeserializationError(QAbstractProtobufSerializer::DeserializationError error, const char *errorString) {
+        //Error is not logged, malformed input may be received at high rate. Reason is available using
+        //QAbstractProtobufSerializer::deserializationErrorString()
+        if (deserializationError != QAbstractProtobufSerializer::NoError) {
+            return;
+        }
+        deserializationError = error;
+        deserializationErrorString = errorString;
+    }
+
+    static bool hasDeserializationError() {
+        return deserializationError != QAbstractProtobufSerializer::NoError;
+    }
+
+    static void resetDeserializationError() {
+        deserializationError = QAbstractProtobufSerializer::NoError;
+        deserializationErrorString = nullptr;
+    }
+
+    /*!
+     * \brief Records error if \a it was moved out of bounds of message, e.g. by custom deserialization handler
+     */
+    static bool checkIterator(const QProtobufSelfcheckIterator &it) {
+        if (it.isValid()) {
+            return true;
+        }
+        setDeserializationError(QAbstractProtobufSerializer::UnexpectedEndOfStreamError,
+                                "Field exceeds bounds of message. Deserialization failed");
+        return false;
+    }
+
+    //! \private
+    static bool checkDecodeStatus(DecodeStatus status) {
+        switch (status) {
+        case DecodeOk:
+            return true;
+        case DecodeTruncated:
+            setDeserializationError(QAbstractProtobufSerializer::UnexpectedEndOfStreamError,
+                                    "Container is less than required fields number. Deserialization failed");
+            break;
+        case DecodeMalformedVarint:
+            setDeserializationError(QAbstractProtobufSerializer::InvalidFormatError,
+                                    "Malformed varint value. Deserialization failed");
+            break;
+        }
+        return false;
+    }
+
+    /*!
+     * \brief Decodes value of type \a V at position of \a it. Bounds are checked once per value
+     *
+     * \details If value cannot be decoded, error is recorded, \a it is moved to the end of data and
+     *          default value is returned
+     */
+    template <typename V>
+    static V deserializeValue(QProtobufSelfcheckIterator &it) {
+        const char *begin = it.data();
+        const char *current = begin;
+        V value;
+        if (!checkDecodeStatus(decodeBasic<V>(current, begin + it.size(), value))) {
+            it += it.size();
+            return V();
+        }
+        it += static_cast<int>(current - begin);
+        return value;
+    }
+
+    template <typename V,
+              typename std::enable_if_t<std::is_integral<V>::value
+                                        && std::is_unsigned<V>::value, int> = 0>
+    static V deserializeVarintCommon(QProtobufSelfcheckIterator &it) {
+        return deserializeValue<V>(it);
+    }
+
+    //-------------Integral and floating point types deserializers---------------
+    template <typename V,
+              typename std::enable_if_t<!(std::is_same<QString, V>::value
+                                        || std::is_same<QByteArray, V>::value), int> = 0>
+    static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
+        V value = deserializeValue<V>(it);
+        if (!hasDeserializationError()) {
+            variantValue = QVariant::fromValue(value);
+        }
     }
 
     //-----------------QString and QByteArray types deserializers----------------
     template <typename V,
               typename std::enable_if_t<std::is_same<QByteArray, V>::value, int> = 0>
     static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        variantValue = QVariant::fromValue(deserializeLengthDelimited(it));
+        QByteArray value = deserializeLengthDelimited(it);
+        if (!hasDeserializationError()) {
+            variantValue = QVariant::fromValue(value);
+        }
     }
 
     template <typename V,
               typename std::enable_if_t<std::is_same<QString, V>::value, int> = 0>
     static void deserializeBasic(QProtobufSelfcheckIterator &it, QVariant &variantValue) {
-        variantValue = QVariant::fromValue(QString::fromUtf8(deserializeLengthDelimited(it)));
+        QProtobufSelfcheckIterator data = deserializeLengthDelimitedRange(it);
+        if (!hasDeserializationError()) {
+            variantValue = QVariant::fromValue(QString::fromUtf8(data.data(), data.size()));
+        }
     }
 
     //-------------------------List types deserializers--------------------------
@@ -357,27 +1106,54 @@ public:
     static void deserializeList(QProtobufSelfcheckIterator &it, QVariant &previousValue) {
         qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
 
+        //Bounds of packed list are checked once, elements are decoded from raw buffer
+        QProtobufSelfcheckIterator range = deserializeLengthDelimitedRange(it);
+
         QList<V> out;
-        unsigned int count = deserializeVarintCommon<uint32>(it);
-        QProtobufSelfcheckIterator lastVarint = it + count;
-        while (it != lastVarint) {
-            QVariant variantValue;
-            deserializeBasic<V>(it, variantValue);
-            out.append(variantValue.value<V>());
+        if (hasDeserializationError() || !checkDecodeStatus(decodePackedList<V>(range.data(), range.data() + range.size(), out))) {
+            return;
+        }
+        if (merging) {
+            QtProtobufPrivate::valueRef<QList<V>>(previousValue).append(out);
+        } else {
+            previousValue.setValue(out);
         }
-        previousValue.setValue(out);
     }
 
     //###########################################################################
     //                             Common functions
     //###########################################################################
-    static QByteArray deserializeLengthDelimited(QProtobufSelfcheckIterator &it) {
-        qProtoDebug() << __func__ << "currentByte:" << QString::number((*it), 16);
-
+    /*!
+     * \brief Reads length of length-delimited field and moves \a it behind the field
+     *
+     * \return Iterator bounded by the field data, data is not copied. If field length exceeds size of
+     *         data, error is recorded and empty iterator is returned
+     */
+    static QProtobufSelfcheckIterator deserializeLengthDelimitedRange(QProtobufSelfcheckIterator &it) {
         unsigned int length = deserializeVarintCommon<uint32>(it);
-        QByteArray result((QByteArray::const_iterator&)it, length); //TODO: it's possible to avoid buffer copying by setuping new "end of QByteArray";
+        if (length > static_cast<unsigned int>(it.size())) {
+            setDeserializationError(QAbstractProtobufSerializer::UnexpectedEndOfStreamError,
+                                    "Container is less than required fields number. Deserialization failed");
+            it += it.size();
+            return it.subRange(0);
+        }
+        QProtobufSelfcheckIterator range = it.subRange(static_cast<int>(length));
         it += length;
-        return result;
+        return range;
+    }
+
+    /*!
+     * \brief Reads length-delimited field data
+     *
+     * \details Returns slice of input buffer if QProtobufSerializer::RawDataBytes option is active,
+     *          otherwise field data is copied
+     */
+    static QByteArray deserializeLengthDelimited(QProtobufSelfcheckIterator &it) {
+        QProtobufSelfcheckIterator data = deserializeLengthDelimitedRange(it);
+        if (deserializationOptions.testFlag(QProtobufSerializer::RawDataBytes)) {
+            return QByteArray::fromRawData(data.data(), data.size());
+        }
+        return QByteArray(data.data(), data.size());
     }
 
     static QByteArray serializeLengthDelimited(const QByteArray &data) {
@@ -389,6 +1165,7 @@ public:
     }
 
     static bool decodeHeader(QProtobufSelfcheckIterator &it, int &fieldIndex, WireTypes &wireType);
+    static bool decodeFieldHeader(QProtobufSelfcheckIterator &it, int &fieldIndex, WireTypes &wireType);
     static QByteArray encodeHeader(int fieldIndex, WireTypes wireType);
 
     /*!
@@ -416,22 +1193,47 @@ public:
 
     template <typename T, QByteArray(*s)(const T &, int &), Deserializer d, WireTypes type,
     typename std::enable_if_t<!std::is_base_of<QObject, T>::value, int> = 0>
-    static void wrapSerializer() {
-        handlers[qMetaTypeId<T>()] = {
+    static void wrapSerializer(SerializerRegistry &registry) {
+        registerHandlers(registry, qMetaTypeId<T>(), {
                 serializeWrapper<T, s>,
                 d,
-                type
-        };
+                type,
+                sizeWrapper<T>,
+                writeWrapper<T, type>,
+                IsList<T>::value
+        });
     }
 
     template <typename T, typename S, QByteArray(*s)(const S &, int &), Deserializer d, WireTypes type,
     typename std::enable_if_t<!std::is_base_of<QObject, T>::value, int> = 0>
-    static void wrapSerializer() {
-        handlers[qMetaTypeId<T>()] = {
+    static void wrapSerializer(SerializerRegistry &registry) {
+        registerHandlers(registry, qMetaTypeId<T>(), {
                 serializeWrapper<S, s>,
                 d,
-                type
-        };
+                type,
+                sizeWrapper<T>,
+                writeWrapper<T, type>,
+                IsList<T>::value
+        });
+    }
+
+    static void registerHandlers(SerializerRegistry &registry, int userType, const SerializationHandlers &typeHandlers) {
+        if (static_cast<int>(registry.size()) <= userType) {
+            registry.resize(userType + 1);
+        }
+        registry[userType] = typeHandlers;
+    }
+
+    /*!
+     * \brief Returns basic type handlers for \a userType or nullptr if \a userType is not basic type
+     */
+    static const SerializationHandlers *basicHandler(int userType) {
+        const SerializerRegistry &registry = handlers();
+        if (userType < 0 || userType >= static_cast<int>(registry.size())) {
+            return nullptr;
+        }
+        const SerializationHandlers &typeHandlers = registry[userType];
+        return typeHandlers.serializer != nullptr ? &typeHandlers : nullptr;
     }
 
     // this set of 3 methods is used to skip bytes corresponding to an unexpected property
@@ -442,10 +1244,91 @@ public:
 
     QByteArray serializeProperty(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty);
     void deserializeProperty(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it);
+    void deserializeField(QObject *object, const QProtobufMetaObject &metaObject, int fieldNumber, WireTypes wireType,
+                          QProtobufSelfcheckIterator &it, const char *fieldBegin);
+    void deserializeUnknownField(QObject *object, const QProtobufMetaObject &metaObject, int fieldNumber, WireTypes wireType,
+                                 QProtobufSelfcheckIterator &it, const char *fieldBegin);
+    void deserializeMessage(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it, bool clear = false);
+    void deserializeMessageFields(QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it);
+    /*!
+     * \brief Merges fields stored in first \a size bytes of \a data into \a object
+     *
+     * \details RawDataBytes option is not applied, bytes fields never refer \a data
+     * \return false if data is malformed
+     */
+    bool mergeFields(QObject *object, const QProtobufMetaObject &metaObject, const QByteArray &data, int size);
+
+    bool deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it);
+
+    SerializationContext *activeContext() const {
+        return (context != nullptr && context->owner == this) ? context : nullptr;
+    }
+
+    /*!
+     * \brief Serializes fields of \a object selected by \a mask, all fields if \a mask is nullptr
+     */
+    QByteArray serializeMessage(const QObject *object, const QProtobufMetaObject &metaObject, const QProtobufFieldMask *mask);
+    void serializeMessageInContext(const QObject *object, const QProtobufMetaObject &metaObject);
+    void serializeMaskedMessageInContext(const QObject *object, const QProtobufMetaObject &metaObject);
+    void serializePropertyInContext(const QVariant &propertyValue, const QProtobufMetaProperty &metaProperty,
+                                    const QtProtobufPrivate::SerializationHandler *handler = nullptr);
+    void serializeFieldInContext(const QVariant &propertyValue, const QProtobufFieldInfo &field);
+
+    /*!
+     * \brief Serializes length-delimited field with index \a fieldIndex in active context
+     *
+     * \details At Sizing stage size of content produced by \a serializeContent is stored to context,
+     *          unless only total size is measured. At Writing stage stored size is used as length prefix of content
+     */
+    template <typename F>
+    void serializeLengthDelimitedInContext(int fieldIndex, F serializeContent) {
+        if (context->stage == SerializationContext::Sizing) {
+            size_t slot = context->sizes.size();
+            if (!context->measuring) {
+                context->sizes.push_back(0);
+            }
+            int initialSize = context->size;
+            serializeContent();
+            int size = context->size - initialSize;
+            if (!context->measuring) {
+                context->sizes[slot] = size;
+            }
+            context->size += headerSize(fieldIndex) + varintSize(size);
+        } else {
+            Q_ASSERT(context->cursor < context->sizes.size());
+            int size = context->sizes[context->cursor++];
+            context->reserve(headerSize(fieldIndex) + varintSize(size));
+            writeHeader(fieldIndex, LengthDelimited, context->out);
+            writeVarint(size, context->out);
+            serializeContent();
+        }
+    }
+
+    template <typename T>
+    void serializeFieldInContext(const T &value, int fieldIndex, WireTypes type) {
+        if (context->stage == SerializationContext::Sizing) {
+            context->size += sizeField(value, fieldIndex);
+        } else {
+            if (context->device != nullptr) {
+                context->reserve(sizeField(value, fieldIndex));
+            }
+            writeField(value, fieldIndex, type, context->out);
+        }
+    }
+
+    static thread_local SerializationContext *context;
+    static thread_local QProtobufSerializer::Options deserializationOptions;
+    static thread_local bool merging;//Repeated fields are appended and nested messages are merged if set
+    static thread_local NotificationBatch *notificationBatch;//Batch of message that is deserialized at the moment
+    static thread_local RepeatedFieldsBuilder *repeatedFieldsBuilder;//Builder of message that is deserialized at the moment
+    static thread_local const QByteArray *input;//Input buffer that is deserialized at the moment, unknown fields refer to it
+    static thread_local const QProtobufFieldMask *fieldMask;//Mask of fields of message that is deserialized at the moment, nullptr if all fields are deserialized
+    static thread_local QAbstractProtobufSerializer::DeserializationError deserializationError;//First error of last deserialization
+    static thread_local const char *deserializationErrorString;
 
-    void deserializeMapPair(QVariant &key, QVariant &value, QProtobufSelfcheckIterator &it);
+    QProtobufSerializer::Options options;
 private:
-    static SerializerRegistry handlers;
+    static const SerializerRegistry &handlers();
     QProtobufSerializer *q_ptr;
 };
 
@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufstreamparser.h"
+#include "qprotobufserializer.h"
+#include "qprotobufserializer_p.h"
+
+#include <limits>
+
+using namespace QtProtobuf;
+
+namespace {
+/*!
+ * \private
+ * \brief Returns size of complete fields at the beginning of [\a begin, \a end) range
+ *
+ * \details \a count is incremented by number of complete fields. \a required is set to size of first incomplete
+ *          field if its header and length are already decoded, or to 0 otherwise. Returns -1 if range is malformed
+ */
+int scanCompleteFields(const char *begin, const char *end, int &count, int &required)
+{
+    const char *it = begin;
+    required = 0;
+    while (it < end) {
+        const char *fieldBegin = it;
+        quint64 header = 0;
+        QProtobufSerializerPrivate::DecodeStatus status = QProtobufSerializerPrivate::decodeVarint(it, end, header);
+        if (status == QProtobufSerializerPrivate::DecodeTruncated) {
+            break;
+        }
+        if (!QProtobufSerializerPrivate::checkDecodeStatus(status)) {
+            return -1;
+        }
+
+        quint64 fieldSize = 0;
+        switch (static_cast<WireTypes>(header & 0x07)) {
+        case Varint: {
+            quint64 value = 0;
+            status = QProtobufSerializerPrivate::decodeVarint(it, end, value);
+            if (status == QProtobufSerializerPrivate::DecodeTruncated) {
+                return static_cast<int>(fieldBegin - begin);
+            }
+            if (!QProtobufSerializerPrivate::checkDecodeStatus(status)) {
+                return -1;
+            }
+            break;
+        }
+        case Fixed32:
+            fieldSize = sizeof(decltype(fixed32::_t));
+            break;
+        case Fixed64:
+            fieldSize = sizeof(decltype(fixed64::_t));
+            break;
+        case LengthDelimited:
+            status = QProtobufSerializerPrivate::decodeVarint(it, end, fieldSize);
+            if (status == QProtobufSerializerPrivate::DecodeTruncated) {
+                return static_cast<int>(fieldBegin - begin);
+            }
+            if (!QProtobufSerializerPrivate::checkDecodeStatus(status)) {
+                return -1;
+            }
+            break;
+        default:
+            QProtobufSerializerPrivate::setDeserializationError(QAbstractProtobufSerializer::InvalidHeaderError,
+                                                                "Message received doesn't contains valid header byte. Seems stream is broken");
+            return -1;
+        }
+
+        quint64 headerSize = static_cast<quint64>(it - fieldBegin);
+        if (fieldSize > static_cast<quint64>(std::numeric_limits<int>::max()) - headerSize) {
+            QProtobufSerializerPrivate::setDeserializationError(QAbstractProtobufSerializer::UnexpectedEndOfStreamError,
+                                                                "Field size exceeds maximum size of QByteArray. Deserialization failed");
+            return -1;
+        }
+        if (fieldSize > static_cast<quint64>(end - it)) {
+            required = static_cast<int>(headerSize + fieldSize);
+            return static_cast<int>(fieldBegin - begin);
+        }
+        it += fieldSize;
+        ++count;
+    }
+    return static_cast<int>(it - begin);
+}
+}
+
+QProtobufStreamParser::QProtobufStreamParser(QProtobufSerializer *serializer, QObject *object, const QProtobufMetaObject &metaObject) : m_serializer(serializer)
+  , m_object(object)
+  , m_metaObject(metaObject)
+  , m_required(0)
+{
+    Q_ASSERT_X(serializer != nullptr, "QProtobufStreamParser", "Serializer is null");
+    Q_ASSERT_X(object != nullptr, "QProtobufStreamParser", "Object is null");
+}
+
+int QProtobufStreamParser::feed(const QByteArray &chunk)
+{
+    //Complete fields are deserialized directly from chunk, only incomplete tail is kept
+    QByteArray data = chunk;
+    if (!m_pending.isEmpty()) {
+        m_pending.append(chunk);
+        if (m_required > m_pending.size()) {
+            return 0;
+        }
+        data = m_pending;
+    }
+
+    int count = 0;
+    int consumed = parse(data, count);
+    if (consumed < 0) {
+        m_pending.clear();
+        m_required = 0;
+        return -1;
+    }
+    m_pending = consumed > 0 ? data.mid(consumed) : data;
+    return count;
+}
+
+int QProtobufStreamParser::feed(QIODevice *device)
+{
+    Q_ASSERT_X(device != nullptr, "QProtobufStreamParser", "Device is null");
+    return feed(device->readAll());
+}
+
+void QProtobufStreamParser::reset()
+{
+    m_pending.clear();
+    m_required = 0;
+}
+
+int QProtobufStreamParser::parse(const QByteArray &data, int &count)
+{
+    QProtobufSerializerPrivate::resetDeserializationError();
+    int size = scanCompleteFields(data.constData(), data.constData() + data.size(), count, m_required);
+    if (size > 0 && !m_serializer->dPtr->mergeFields(m_object, m_metaObject, data, size)) {
+        return -1;
+    }
+    return size;
+}
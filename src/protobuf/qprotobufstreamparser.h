@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufStreamParser
+
+#include "qtprotobufglobal.h"
+#include "qprotobufmetaobject.h"
+
+#include <QByteArray>
+#include <QIODevice>
+
+namespace QtProtobuf {
+
+class QProtobufSerializer;
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufStreamParser class deserializes message from chunks of data as they arrive
+ *
+ * \details Chunks may be split at any byte. Each top-level field is merged into message as soon as its last
+ *          byte is fed, so message is populated while it's streamed. Incomplete tail of chunk is kept until
+ *          next chunk arrives; complete fields are deserialized directly from the chunk they arrived in.
+ *          Nested messages are deserialized when top-level field that contains them is complete.
+ *          Fields are merged same as by QAbstractProtobufSerializer::mergeFrom(). In case if stream is
+ *          malformed, feed() returns -1 and reason is available using QProtobufSerializer::deserializationError().
+ *          Parser doesn't throw exceptions. QProtobufSerializer::RawDataBytes option is ignored by parser, since
+ *          chunks are released as soon as they are parsed, bytes fields are always copied.
+ *
+ * \code
+ * SimpleMessage message;
+ * QProtobufStreamParser parser(serializer, &message);
+ * connect(reply, &QIODevice::readyRead, [reply, &parser] {
+ *     parser.feed(reply);
+ * });
+ * \endcode
+ */
+class Q_PROTOBUF_EXPORT QProtobufStreamParser
+{
+public:
+    QProtobufStreamParser(QProtobufSerializer *serializer, QObject *object, const QProtobufMetaObject &metaObject);
+
+    template<typename T>
+    QProtobufStreamParser(QProtobufSerializer *serializer, T *object) : QProtobufStreamParser(serializer, object, T::protobufMetaObject) {}
+
+    /*!
+     * \brief Feeds next \a chunk of serialized message
+     * \return Number of fields that were completed by \a chunk or -1 if stream is malformed
+     */
+    int feed(const QByteArray &chunk);
+
+    /*!
+     * \brief Feeds all data that is available in \a device
+     * \return Number of fields that were completed by data read from \a device or -1 if stream is malformed
+     */
+    int feed(QIODevice *device);
+
+    /*!
+     * \brief Returns true if data fed so far ends at field boundary, so stream may be finished at this point
+     */
+    bool isComplete() const { return m_pending.isEmpty(); }
+
+    /*!
+     * \brief Returns number of bytes of incomplete field, that are kept until next chunk
+     */
+    int pendingSize() const { return m_pending.size(); }
+
+    /*!
+     * \brief Drops incomplete field, so new message could be fed. Message object is not cleared
+     */
+    void reset();
+
+private:
+    Q_DISABLE_COPY(QProtobufStreamParser)
+    int parse(const QByteArray &data, int &count);
+
+    QProtobufSerializer *m_serializer;
+    QObject *m_object;
+    const QProtobufMetaObject &m_metaObject;
+    QByteArray m_pending;
+    int m_required;
+};
+
+}
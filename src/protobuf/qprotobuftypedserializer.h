@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufTypedSerializer
+
+#include "qtprotobufglobal.h"
+#include "qtprotobuftypes.h"
+#include "qprotobufselfcheckiterator.h"
+#include "qprotobuflazymessagepointer.h"
+
+#include <vector>
+
+namespace QtProtobuf {
+
+class QProtobufSerializerPrivate;
+class QProtobufMetaObject;
+struct QProtobufFieldInfo;
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufTypedWriter class is used by generated typed serializers to write message fields
+ *        without QVariant and QMetaProperty roundtrips
+ *
+ * \details Supported value types are QtProtobuf scalar types, QString, QByteArray and lists of them.
+ *          Fields of other types are serialized using reflective path by writeProperty().
+ *          Generated serializer is called twice: at sizing and writing stages of QProtobufSerializer,
+ *          so it must write the same fields at both stages.
+ */
+class Q_PROTOBUF_EXPORT QProtobufTypedWriter
+{
+public:
+    /*!
+     * \brief Writes \a value as field with number \a fieldNumber
+     */
+    template <typename T>
+    void write(int fieldNumber, const T &value);
+
+    /*!
+     * \brief Writes enum \a value as field with number \a fieldNumber
+     */
+    void writeEnum(int fieldNumber, int64 value);
+
+    /*!
+     * \brief Writes nested message \a object as field with number \a fieldNumber
+     */
+    void writeMessage(int fieldNumber, const QObject *object, const QProtobufMetaObject &metaObject);
+
+    /*!
+     * \brief Writes nested message \a message as field with number \a fieldNumber. Message that is
+     *        kept serialized is written as is, unless QProtobufSerializer::Deterministic option is set
+     */
+    template <typename T>
+    void writeMessage(int fieldNumber, const QProtobufLazyMessagePointer<T> &message) {
+        if (message.isSerialized() && keepsSerializedMessages()) {
+            writeSerializedMessage(fieldNumber, message.serializedData());
+            return;
+        }
+        writeMessage(fieldNumber, message.get(), T::protobufMetaObject);
+    }
+
+    /*!
+     * \brief Writes field with number \a fieldNumber using reflective path
+     */
+    void writeProperty(int fieldNumber);
+
+private:
+    QProtobufTypedWriter(QProtobufSerializerPrivate *serializer, const QObject *object, const QProtobufMetaObject &metaObject);
+    Q_DISABLE_COPY(QProtobufTypedWriter)
+    bool keepsSerializedMessages() const;
+    void writeSerializedMessage(int fieldNumber, const QByteArray &data);
+
+    friend class QProtobufSerializerPrivate;
+    QProtobufSerializerPrivate *m_serializer;
+    const QObject *m_object;
+    const QProtobufMetaObject &m_metaObject;
+};
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufTypedReader class is used by generated typed deserializers to read message fields
+ *        without QVariant and QMetaProperty roundtrips
+ *
+ * \details Generated deserializer reads field headers using next() and dispatches values by fieldNumber().
+ *          Fields that are not known to generated deserializer are read using readProperty(), that
+ *          follows reflective path and skips fields that are not part of message.
+ */
+class Q_PROTOBUF_EXPORT QProtobufTypedReader
+{
+public:
+    /*!
+     * \brief Reads header of next field
+     *
+     * \return false if end of message is reached or message is malformed
+     */
+    bool next();
+
+    /*!
+     * \brief Returns number of field which header was read by last next() call
+     */
+    int fieldNumber() const { return m_fieldNumber; }
+
+    /*!
+     * \brief Reads value of current field to \a value
+     *
+     * \details Same as reflective path, packed lists replace \a value or are appended to it if
+     *          isMerging() is true. Lists of strings and byte arrays are appended by single element
+     */
+    template <typename T>
+    void read(T &value);
+
+    /*!
+     * \brief Reads enum value of current field
+     */
+    int64 readEnum();
+
+    /*!
+     * \brief Reads nested message of current field to \a object
+     *
+     * \return false if nested message is malformed
+     */
+    bool readMessage(QObject *object, const QProtobufMetaObject &metaObject);
+
+    /*!
+     * \brief Returns true if data is merged into existing message, so nested messages should be
+     *        read into existing objects
+     */
+    bool isMerging() const;
+
+    /*!
+     * \brief Returns true if nested messages should be kept serialized until first access,
+     *        see QProtobufSerializer::LazyMessages
+     */
+    bool isLazy() const;
+
+    /*!
+     * \brief Returns QProtobufSerializer options of serializer that reads message, nested messages kept
+     *        serialized are deserialized using them
+     */
+    int options() const;
+
+    /*!
+     * \brief Returns serialized nested message of current field without deserializing it
+     */
+    QByteArray readSerializedMessage();
+
+    /*!
+     * \brief Reads current field using reflective path
+     */
+    void readProperty();
+
+    /*!
+     * \brief Schedules notify signal of current field, that was read directly into message member.
+     *        Signal is emitted once, when whole message is read
+     */
+    void notifyChanged();
+
+private:
+    QProtobufTypedReader(QProtobufSerializerPrivate *serializer, QObject *object, const QProtobufMetaObject &metaObject, QProtobufSelfcheckIterator &it);
+    ~QProtobufTypedReader();
+    Q_DISABLE_COPY(QProtobufTypedReader)
+
+    friend class QProtobufSerializerPrivate;
+    QProtobufSerializerPrivate *m_serializer;
+    QObject *m_object;
+    const QProtobufMetaObject &m_metaObject;
+    QProtobufSelfcheckIterator &m_it;
+    int m_fieldNumber;
+    WireTypes m_wireType;
+    const char *m_fieldBegin;
+    std::vector<const QProtobufFieldInfo *> m_changedFields;
+};
+
+}
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qprotobufunknownfields.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace QtProtobuf;
+
+void QProtobufUnknownFields::append(const QByteArray &buffer, int offset, int size)
+{
+    Q_ASSERT_X(offset >= 0 && size >= 0 && offset + size <= buffer.size(), "QProtobufUnknownFields", "Slice is out of buffer range");
+    //Raw data buffer doesn't own its data, so it may be freed while slice is alive. Small slice of big
+    //buffer is copied, to not keep whole input alive because of single unknown field
+    bool isRawData = buffer.capacity() < buffer.size();
+    if (isRawData || size < buffer.size() / SharedSliceMinRatio) {
+        m_slices.push_back({QByteArray(buffer.constData() + offset, size), 0, size});
+        return;
+    }
+    m_slices.push_back({buffer, offset, size});
+}
+
+void QProtobufUnknownFields::clear()
+{
+    m_slices.clear();
+}
+
+int QProtobufUnknownFields::size() const
+{
+    int result = 0;
+    for (const auto &slice : m_slices) {
+        result += slice.size;
+    }
+    return result;
+}
+
+char *QProtobufUnknownFields::write(char *out) const
+{
+    for (const auto &slice : m_slices) {
+        memcpy(out, slice.buffer.constData() + slice.offset, static_cast<size_t>(slice.size));
+        out += slice.size;
+    }
+    return out;
+}
+
+char *QProtobufUnknownFields::writeOrdered(char *out) const
+{
+    if (m_slices.size() < 2) {
+        return write(out);
+    }
+
+    std::vector<const Slice *> ordered;
+    ordered.reserve(m_slices.size());
+    for (const auto &slice : m_slices) {
+        ordered.push_back(&slice);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const Slice *a, const Slice *b) {
+        return fieldNumber(*a) < fieldNumber(*b);
+    });
+
+    for (const Slice *slice : ordered) {
+        memcpy(out, slice->buffer.constData() + slice->offset, static_cast<size_t>(slice->size));
+        out += slice->size;
+    }
+    return out;
+}
+
+quint64 QProtobufUnknownFields::fieldNumber(const Slice &slice)
+{
+    //Slice starts with valid field header, it's validated when field is deserialized
+    const unsigned char *it = reinterpret_cast<const unsigned char *>(slice.buffer.constData() + slice.offset);
+    const unsigned char *end = it + slice.size;
+    quint64 header = 0;
+    for (int shift = 0; it != end && shift < 64; shift += 7) {
+        header |= static_cast<quint64>(*it & 0x7f) << shift;
+        if ((*it++ & 0x80) == 0) {
+            break;
+        }
+    }
+    return header >> 3;
+}
+
+QByteArray QProtobufUnknownFields::toByteArray() const
+{
+    QByteArray result(size(), Qt::Uninitialized);
+    write(result.data());
+    return result;
+}
+
+bool QProtobufUnknownFields::operator ==(const QProtobufUnknownFields &other) const
+{
+    return toByteArray() == other.toByteArray();
+}
+
+bool QProtobufUnknownFields::operator !=(const QProtobufUnknownFields &other) const
+{
+    return !(*this == other);
+}
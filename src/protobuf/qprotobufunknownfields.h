@@ -0,0 +1,113 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once //QProtobufUnknownFields
+
+#include "qtprotobufglobal.h"
+
+#include <QByteArray>
+
+#include <vector>
+
+namespace QtProtobuf {
+
+/*!
+ * \ingroup QtProtobuf
+ * \brief The QProtobufUnknownFields class keeps fields of message that are not described by its schema
+ *
+ * \details Fields are kept as slices of serialized input: input buffer is referenced by slices, not copied,
+ *          if field takes significant part of it. Fields of raw data buffers and small fields of big buffers
+ *          are copied.
+ *          QProtobufSerializer writes fields back as is after known fields of message, so data of fields
+ *          added by newer schema is not lost when message is passed through.
+ */
+class Q_PROTOBUF_EXPORT QProtobufUnknownFields
+{
+public:
+    /*!
+     * \brief Appends field that occupies \a size bytes of \a buffer starting from \a offset.
+     *        \a buffer is shared with slice, unless it's raw data or field is less than
+     *        1/SharedSliceMinRatio of \a buffer
+     */
+    void append(const QByteArray &buffer, int offset, int size);
+
+    /*!
+     * \brief Removes all fields
+     */
+    void clear();
+
+    /*!
+     * \brief Returns true if there are no unknown fields
+     */
+    bool isEmpty() const { return m_slices.empty(); }
+
+    /*!
+     * \brief Returns number of unknown fields
+     */
+    int count() const { return static_cast<int>(m_slices.size()); }
+
+    /*!
+     * \brief Returns size of serialized unknown fields in bytes
+     */
+    int size() const;
+
+    /*!
+     * \brief Copies serialized unknown fields to \a out, that has at least size() bytes available
+     * \return Pointer to byte following the last written one
+     */
+    char *write(char *out) const;
+
+    /*!
+     * \brief Copies serialized unknown fields to \a out ordered by field number. Fields with equal numbers
+     *        are kept in order of appearance
+     * \return Pointer to byte following the last written one
+     */
+    char *writeOrdered(char *out) const;
+
+    /*!
+     * \brief Returns serialized unknown fields
+     */
+    QByteArray toByteArray() const;
+
+    bool operator ==(const QProtobufUnknownFields &other) const;
+    bool operator !=(const QProtobufUnknownFields &other) const;
+
+private:
+    enum {
+        SharedSliceMinRatio = 8
+    };
+
+    struct Slice {
+        QByteArray buffer;
+        int offset;
+        int size;
+    };
+
+    static quint64 fieldNumber(const Slice &slice);
+
+    std::vector<Slice> m_slices;
+};
+
+}
@@ -26,6 +26,7 @@
 #include "qtprotobuftypes.h"
 #include "qprotobufobject.h"
 
+#include <mutex>
 #include <type_traits>
 
 #define registerProtobufType(X) qRegisterMetaType<X>(# X);\
@@ -60,7 +61,10 @@ std::list<RegisterFunction>& registerFunctions() {
 }
 
 void qRegisterProtobufTypes() {
+    //Lock is recursive, so registration functions may call qRegisterProtobufTypes() as well
+    static std::recursive_mutex lock;
     static bool registred = false;
+    std::lock_guard<std::recursive_mutex> locker(lock);
     if (registred) {
         return;
     }
@@ -101,4 +105,8 @@ void qRegisterProtobufTypes() {
         registerFunc();
     }
 }
+
+void qFreezeProtobufTypes() {
+    QtProtobufPrivate::freezeHandlers();
+}
 }
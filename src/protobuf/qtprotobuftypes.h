@@ -259,6 +259,14 @@ using DoubleList = QList<double>;
  */
 Q_PROTOBUF_EXPORT void qRegisterProtobufTypes();
 
+/*!
+ * \ingroup QtProtobuf
+ * \brief qFreezeProtobufTypes forbids replacement of registered serialization handlers
+ * This method should be called once all types are registered, before serializers are used from worker
+ * threads. Handlers of types that are registered afterwards are still added.
+ */
+Q_PROTOBUF_EXPORT void qFreezeProtobufTypes();
+
 /*! \} */
 
 //!\private
@@ -284,8 +284,9 @@ void registerQtTypeHandler() {
                                            },
                                            [](const QtProtobuf::QAbstractProtobufSerializer *serializer, QtProtobuf::QProtobufSelfcheckIterator &it, QVariant &value) {
                                                PType object;
-                                               serializer->deserializeObject(&object, PType::protobufMetaObject, it);
-                                               value = QVariant::fromValue<QType>(convert(object));
+                                               if (serializer->deserializeObject(&object, PType::protobufMetaObject, it)) {
+                                                   value = QVariant::fromValue<QType>(convert(object));
+                                               }
                                            }, QtProtobufPrivate::ObjectHandler });
 }
 
@@ -27,6 +27,13 @@
 
 #include "simpletest.qpb.h"
 
+#include <qprotobufstreamparser.h>
+#include <qprotobufmessagepool.h>
+
+#include <QThread>
+
+#include <atomic>
+
 using namespace qtprotobufnamespace::tests;
 using namespace QtProtobuf::tests;
 using namespace QtProtobuf;
@@ -415,6 +422,45 @@ TEST_F(DeserializationTest, RepeatedBytesMessageTest)
                                                              QByteArray::fromHex("010203040506")}));
 }
 
+TEST_F(DeserializationTest, RawDataBytesDeserializeTest)
+{
+    QByteArray data = QByteArray::fromHex("0a06010203040506");
+    SimpleBytesMessage test;
+    test.deserialize(serializer.get(), data);
+    ASSERT_TRUE(test.testFieldBytes() == QByteArray::fromHex("010203040506"));
+    ASSERT_TRUE(test.testFieldBytes().constData() != data.constData() + 2);
+
+    serializer->setOptions(QProtobufSerializer::RawDataBytes);
+    SimpleBytesMessage rawTest;
+    rawTest.deserialize(serializer.get(), data);
+    ASSERT_TRUE(rawTest.testFieldBytes() == QByteArray::fromHex("010203040506"));
+    ASSERT_TRUE(rawTest.testFieldBytes().constData() == data.constData() + 2);
+
+    RepeatedBytesMessage repeatedTest;
+    data = QByteArray::fromHex("0a060102030405060a04ffffffff");
+    repeatedTest.deserialize(serializer.get(), data);
+    ASSERT_EQ(2, repeatedTest.testRepeatedBytes().count());
+    ASSERT_TRUE(repeatedTest.testRepeatedBytes().at(1) == QByteArray::fromHex("ffffffff"));
+    ASSERT_TRUE(repeatedTest.testRepeatedBytes().at(1).constData() == data.constData() + 10);
+}
+
+TEST_F(DeserializationTest, NestedMessageInvalidLengthDeserializeTest)
+{
+    ComplexMessage test;
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("120a3206717765727479")), std::out_of_range);
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("1208320771776572747908")), std::out_of_range);
+}
+
+TEST_F(DeserializationTest, MalformedVarintDeserializeTest)
+{
+    SimpleIntMessage test;
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("08ffff")), std::out_of_range);
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("08ffffffffffffffffffffff01")), std::invalid_argument);
+
+    RepeatedIntMessage repeatedTest;
+    EXPECT_THROW(repeatedTest.deserialize(serializer.get(), QByteArray::fromHex("0a030102ff")), std::out_of_range);
+}
+
 TEST_F(DeserializationTest, RepeatedFloatMessageTest)
 {
     RepeatedFloatMessage test;
@@ -444,6 +490,50 @@ TEST_F(DeserializationTest, RepeatedIntMessageTest)
     ASSERT_TRUE(test2.testRepeatedInt() == int32List({1, 321, -65999, 123245, -3, 3}));
 }
 
+TEST_F(DeserializationTest, RepeatedIntMessageSingleByteRunTest)
+{
+    RepeatedIntMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("0a0e0102030405060708090a0b0c960103"));
+    ASSERT_EQ(14, test.testRepeatedInt().count());
+    ASSERT_TRUE(test.testRepeatedInt() == int32List({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 150, 3}));
+}
+
+TEST_F(DeserializationTest, RepeatedLargeListsTest)
+{
+    DoubleList doubleList;
+    fixed32List fixedList;
+    sint64List sintList;
+    for (int i = 0; i < 1000; i++) {
+        doubleList.append(i * 0.5);
+        fixedList.append(i * 7919);
+        sintList.append((i % 2 ? -1 : 1) * i * i * i);
+    }
+
+    RepeatedDoubleMessage doubleMsg;
+    doubleMsg.setTestRepeatedDouble(doubleList);
+    RepeatedDoubleMessage doubleResult;
+    doubleResult.deserialize(serializer.get(), doubleMsg.serialize(serializer.get()));
+    ASSERT_TRUE(doubleResult.testRepeatedDouble() == doubleList);
+
+    RepeatedFixedIntMessage fixedMsg;
+    fixedMsg.setTestRepeatedInt(fixedList);
+    RepeatedFixedIntMessage fixedResult;
+    fixedResult.deserialize(serializer.get(), fixedMsg.serialize(serializer.get()));
+    ASSERT_TRUE(fixedResult.testRepeatedInt() == fixedList);
+
+    RepeatedSInt64Message sintMsg;
+    sintMsg.setTestRepeatedInt(sintList);
+    RepeatedSInt64Message sintResult;
+    sintResult.deserialize(serializer.get(), sintMsg.serialize(serializer.get()));
+    ASSERT_TRUE(sintResult.testRepeatedInt() == sintList);
+}
+
+TEST_F(DeserializationTest, RepeatedFixedInvalidLengthTest)
+{
+    RepeatedDoubleMessage test;
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("0a099a9999999999b93f00")), std::out_of_range);
+}
+
 TEST_F(DeserializationTest, RepeatedSIntMessageTest)
 {
     RepeatedSIntMessage test;
@@ -867,6 +957,209 @@ TEST_F(DeserializationTest, RedundantFieldIsIgnoredAtDeserializationTest)
     EXPECT_STREQ(test.testComplexField().testFieldString().toStdString().c_str(), "qwerty");
 }
 
+TEST_F(DeserializationTest, UnknownFieldsPreservedTest)
+{
+    quint64 unknownFieldsCount = SimpleIntMessage::protobufMetaObject.unknownFieldsCount();
+    SimpleIntMessage test;
+    //1205717765727420011a020801 length delimited field number 2, varint field number 4 and length delimited field number 3
+    test.deserialize(serializer.get(), QByteArray::fromHex("0896011205717765727420011a020801"));
+    ASSERT_EQ(150, test.testFieldInt());
+    ASSERT_EQ(3, test.unknownFields().count());
+    ASSERT_EQ(unknownFieldsCount + 3, SimpleIntMessage::protobufMetaObject.unknownFieldsCount());
+
+    //Unknown fields are written back after known fields
+    ASSERT_STREQ(test.serialize(serializer.get()).toHex().toStdString().c_str(), "0896011205717765727420011a020801");
+
+    SimpleIntMessage copy(test);
+    ASSERT_TRUE(copy.unknownFields() == test.unknownFields());
+
+    test.deserialize(serializer.get(), QByteArray::fromHex("089601"));
+    ASSERT_TRUE(test.unknownFields().isEmpty());
+
+    //Unknown fields don't refer to raw data input after it's released
+    QByteArray *rawBuffer = new QByteArray(QByteArray::fromHex("0896011205717765727420011a020801"));
+    test.deserialize(serializer.get(), QByteArray::fromRawData(rawBuffer->constData(), rawBuffer->size()));
+    delete rawBuffer;
+    ASSERT_STREQ(test.unknownFields().toByteArray().toHex().toStdString().c_str(), "1205717765727420011a020801");
+}
+
+TEST_F(DeserializationTest, StreamParserTest)
+{
+    //1208320671776572747a length delimited field number 2, 08d3ffffffffffffffff01 varint field number 1
+    QByteArray data = QByteArray::fromHex("1208320671776572747a08d3ffffffffffffffff01");
+    ComplexMessage test;
+    QProtobufStreamParser parser(serializer.get(), &test);
+
+    int fieldsCount = 0;
+    for (int i = 0; i < data.size(); i++) {
+        fieldsCount += parser.feed(data.mid(i, 1));
+        if (i == 9) {
+            ASSERT_TRUE(parser.isComplete());
+            ASSERT_EQ(QString("qwertz"), test.testComplexField().testFieldString());
+            ASSERT_EQ(0, test.testFieldInt());
+        }
+    }
+    ASSERT_EQ(2, fieldsCount);
+    ASSERT_TRUE(parser.isComplete());
+    ASSERT_EQ(-45, test.testFieldInt());
+
+    SimpleIntMessage intTest;
+    QProtobufStreamParser intParser(serializer.get(), &intTest);
+    ASSERT_EQ(0, intParser.feed(QByteArray::fromHex("0896")));
+    ASSERT_FALSE(intParser.isComplete());
+    ASSERT_EQ(1, intParser.feed(QByteArray::fromHex("01")));
+    ASSERT_EQ(150, intTest.testFieldInt());
+
+    //Bytes fields don't refer chunks, even if RawDataBytes option is set
+    serializer->setOptions(QProtobufSerializer::RawDataBytes);
+    SimpleBytesMessage bytesTest;
+    QProtobufStreamParser bytesParser(serializer.get(), &bytesTest);
+    QByteArray chunk = QByteArray::fromHex("0a06010203");
+    ASSERT_EQ(0, bytesParser.feed(chunk));
+    chunk = QByteArray::fromHex("040506");
+    ASSERT_EQ(1, bytesParser.feed(chunk));
+    chunk.fill('\0');
+    ASSERT_TRUE(bytesTest.testFieldBytes() == QByteArray::fromHex("010203040506"));
+    ASSERT_EQ(1, bytesParser.feed(QByteArray::fromHex("0a0201020a")));
+    ASSERT_TRUE(bytesTest.testFieldBytes() == QByteArray::fromHex("0102"));
+}
+
+TEST_F(DeserializationTest, DeserializationErrorTest)
+{
+    SimpleIntMessage test;
+    ASSERT_FALSE(test.tryDeserialize(serializer.get(), QByteArray::fromHex("08ffff")));
+    ASSERT_EQ(QAbstractProtobufSerializer::UnexpectedEndOfStreamError, serializer->deserializationError());
+
+    ASSERT_FALSE(test.tryDeserialize(serializer.get(), QByteArray::fromHex("08ffffffffffffffffffffff01")));
+    ASSERT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+
+    //0f01 field number 1 with undefined wire type 7
+    ASSERT_FALSE(test.tryDeserialize(serializer.get(), QByteArray::fromHex("0f01")));
+    ASSERT_EQ(QAbstractProtobufSerializer::InvalidHeaderError, serializer->deserializationError());
+    ASSERT_FALSE(serializer->deserializationErrorString().isEmpty());
+
+    ASSERT_TRUE(test.tryDeserialize(serializer.get(), QByteArray::fromHex("089601")));
+    ASSERT_EQ(QAbstractProtobufSerializer::NoError, serializer->deserializationError());
+    ASSERT_EQ(150, test.testFieldInt());
+
+    //Fields deserialized before failure are kept
+    ComplexMessage complexTest;
+    ASSERT_FALSE(complexTest.tryDeserialize(serializer.get(), QByteArray::fromHex("08d3ffffffffffffffff01120a3206717765727479")));
+    ASSERT_EQ(QAbstractProtobufSerializer::UnexpectedEndOfStreamError, serializer->deserializationError());
+    ASSERT_EQ(-45, complexTest.testFieldInt());
+
+    //Repeated fields are left unchanged if deserialization failed
+    RepeatedIntMessage repeatedTest;
+    repeatedTest.setTestRepeatedInt({5});
+    EXPECT_THROW(serializer->mergeFrom(&repeatedTest, QByteArray::fromHex("0a0201020a05")), std::out_of_range);
+    ASSERT_EQ(QAbstractProtobufSerializer::UnexpectedEndOfStreamError, serializer->deserializationError());
+    ASSERT_TRUE(repeatedTest.testRepeatedInt() == int32List({5}));
+
+    //Iterator is clamped at bounds of data and end of data is not dereferenced
+    QByteArray raw = QByteArray::fromRawData("\x08", 1);
+    QProtobufSelfcheckIterator it(raw);
+    ++it;
+    ASSERT_TRUE(it.isValid());
+    ASSERT_EQ(0, *it);
+    it += 1;
+    ASSERT_FALSE(it.isValid());
+    ASSERT_EQ(0, it.size());
+}
+
+TEST_F(DeserializationTest, FieldMaskDeserializationTest)
+{
+    quint64 unknownFieldsCount = ComplexMessage::protobufMetaObject.unknownFieldsCount();
+    QByteArray data = QByteArray::fromHex("08d3ffffffffffffffff01120832067177657274791801");
+
+    ComplexMessage test;
+    test.deserialize(serializer.get(), data, QProtobufFieldMask{{1}});
+    ASSERT_EQ(-45, test.testFieldInt());
+    ASSERT_TRUE(test.testComplexField().testFieldString().isEmpty());
+
+    test.deserialize(serializer.get(), data, QProtobufFieldMask{{2, 6}});
+    ASSERT_EQ(0, test.testFieldInt());
+    ASSERT_TRUE(QString::fromUtf8("qwerty") == test.testComplexField().testFieldString());
+
+    //Skipped fields are not stored as unknown fields
+    ASSERT_TRUE(test.unknownFields().isEmpty());
+    ASSERT_EQ(unknownFieldsCount, ComplexMessage::protobufMetaObject.unknownFieldsCount());
+
+    //Length of skipped field is validated
+    EXPECT_THROW(test.deserialize(serializer.get(), QByteArray::fromHex("1208320671776572"), QProtobufFieldMask{{1}}), std::out_of_range);
+
+    //Invalid mask doesn't select any fields and deserialization fails
+    QProtobufFieldMask invalidMask = QProtobufFieldMask::fromPaths({"unknownField"}, ComplexMessage::protobufMetaObject);
+    EXPECT_THROW(test.deserialize(serializer.get(), data, invalidMask), std::invalid_argument);
+    ASSERT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+}
+
+TEST_F(DeserializationTest, DeserializeBatchTest)
+{
+    QList<QByteArray> data;
+    QList<QSharedPointer<ComplexMessage>> messages;
+    for (int i = 0; i < 1000; i++) {
+        data.append(ComplexMessage(i, SimpleStringMessage{QString("string%1").arg(i)}).serialize(serializer.get()));
+        messages.append(QSharedPointer<ComplexMessage>(new ComplexMessage));
+    }
+
+    //Change notifications are emitted from calling thread
+    QThread *callerThread = QThread::currentThread();
+    std::atomic<int> notificationsCount(0);
+    std::atomic<int> foreignNotificationsCount(0);
+    for (const auto &message : messages) {
+        QObject::connect(message.data(), &ComplexMessage::testFieldIntChanged, [&, callerThread] {
+            ++notificationsCount;
+            if (QThread::currentThread() != callerThread) {
+                ++foreignNotificationsCount;
+            }
+        });
+    }
+
+    ASSERT_TRUE(serializer->deserializeBatch(messages, data));
+    for (int i = 0; i < messages.size(); i++) {
+        ASSERT_EQ(i, messages.at(i)->testFieldInt());
+        ASSERT_TRUE(QString("string%1").arg(i) == messages.at(i)->testComplexField().testFieldString());
+    }
+    ASSERT_EQ(999, notificationsCount.load());//Field of first message keeps default value
+    ASSERT_EQ(0, foreignNotificationsCount.load());
+
+    //Malformed message doesn't affect other messages of batch
+    data[500] = QByteArray::fromHex("08ffff");
+    ASSERT_FALSE(serializer->deserializeBatch(messages, data));
+    ASSERT_EQ(499, messages.at(499)->testFieldInt());
+    ASSERT_EQ(501, messages.at(501)->testFieldInt());
+}
+
+TEST_F(DeserializationTest, LazyMessagesTest)
+{
+    serializer->setOptions(QProtobufSerializer::LazyMessages);
+    ComplexMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("08d3ffffffffffffffff0112083206717765727479"));
+    ASSERT_EQ(-45, test.testFieldInt());
+
+    //Nested message that was not accessed is written back as is
+    ASSERT_STREQ(test.serialize(serializer.get()).toHex().toStdString().c_str(), "08d3ffffffffffffffff0112083206717765727479");
+
+    ASSERT_TRUE(QString::fromUtf8("qwerty") == test.testComplexField().testFieldString());
+    ASSERT_STREQ(test.serialize(serializer.get()).toHex().toStdString().c_str(), "08d3ffffffffffffffff0112083206717765727479");
+
+    test.deserialize(serializer.get(), QByteArray::fromHex("08d3ffffffffffffffff0112083206717765727479"));
+    ASSERT_TRUE(test == ComplexMessage({-45, {"qwerty"}}));
+
+    //Malformed message kept serialized is reported on first access and left with default values
+    QProtobufLazyMessagePointer<SimpleStringMessage> lazy;
+    lazy.setSerializedData(QByteArray::fromHex("32067177"), QProtobufSerializer::LazyMessages);
+    ASSERT_TRUE(lazy.isSerialized());
+    ASSERT_FALSE(lazy.hasDecodeError());
+    ASSERT_TRUE(lazy->testFieldString().isEmpty());
+    ASSERT_TRUE(lazy.hasDecodeError());
+    ASSERT_EQ(QAbstractProtobufSerializer::UnexpectedEndOfStreamError, serializer->deserializationError());
+
+    lazy.setSerializedData(QByteArray::fromHex("3206717765727479"), QProtobufSerializer::LazyMessages);
+    ASSERT_TRUE(QString::fromUtf8("qwerty") == lazy->testFieldString());
+    ASSERT_FALSE(lazy.hasDecodeError());
+}
+
 TEST_F(DeserializationTest, FieldIndexRangeTest)
 {
     FieldIndexTest1Message msg1(0);
@@ -901,3 +1194,147 @@ TEST_F(DeserializationTest, SimpleEnumListMessageTest)
                 SimpleEnumListMessage::LOCAL_ENUM_VALUE2,
                 SimpleEnumListMessage::LOCAL_ENUM_VALUE3}));
 }
+
+TEST_F(DeserializationTest, MergeFromTest)
+{
+    ComplexMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("1208320671776572747908d3ffffffffffffffff01"));
+    const SimpleStringMessage *nested = &test.testComplexField();
+
+    test.mergeFrom(serializer.get(), QByteArray::fromHex("082a"));
+    ASSERT_EQ(42, test.testFieldInt());
+    ASSERT_TRUE(QString::fromUtf8("qwerty") == test.testComplexField().testFieldString());
+
+    test.mergeFrom(serializer.get(), QByteArray::fromHex("1208320671776572747a"));
+    ASSERT_EQ(42, test.testFieldInt());
+    ASSERT_TRUE(QString::fromUtf8("qwertz") == test.testComplexField().testFieldString());
+    ASSERT_EQ(nested, &test.testComplexField());
+
+    RepeatedIntMessage repeatedTest;
+    repeatedTest.deserialize(serializer.get(), QByteArray::fromHex("0a03010203"));
+    repeatedTest.mergeFrom(serializer.get(), QByteArray::fromHex("0a020405"));
+    ASSERT_TRUE(repeatedTest.testRepeatedInt() == int32List({1, 2, 3, 4, 5}));
+
+    RepeatedComplexMessage repeatedComplexTest;
+    repeatedComplexTest.deserialize(serializer.get(), QByteArray::fromHex("0a0c081912083206717765727479"));
+    repeatedComplexTest.mergeFrom(serializer.get(), QByteArray::fromHex("0a0c081912083206717765727479"));
+    ASSERT_EQ(2, repeatedComplexTest.testRepeatedComplex().count());
+}
+
+TEST_F(DeserializationTest, MessagePoolTest)
+{
+    QByteArray data = QByteArray::fromHex("0a0c0819120832067177657274790a0c081a12083206717765727479");
+    QProtobufMessagePool pool;
+    RepeatedComplexMessage test;
+    {
+        QProtobufMessagePool::Scope scope(&pool);
+        test.deserialize(serializer.get(), data);
+    }
+    ASSERT_EQ(2, test.testRepeatedComplex().count());
+    ASSERT_EQ(0, pool.count());
+
+    //Released elements are disconnected and returned to pool
+    ComplexMessage *first = test.testRepeatedComplex().at(0).data();
+    int notifications = 0;
+    QObject::connect(first, &ComplexMessage::testFieldIntChanged, [&notifications] { ++notifications; });
+    test.setTestRepeatedComplex({});
+    ASSERT_EQ(2, pool.count());
+
+    //Elements are taken from pool and filled with new values
+    {
+        QProtobufMessagePool::Scope scope(&pool);
+        test.deserialize(serializer.get(), data);
+    }
+    ASSERT_EQ(0, pool.count());
+    ASSERT_EQ(2, test.testRepeatedComplex().count());
+    ASSERT_TRUE(test.testRepeatedComplex().at(0).data() == first || test.testRepeatedComplex().at(1).data() == first);
+    ASSERT_EQ(25, test.testRepeatedComplex().at(0)->testFieldInt());
+    ASSERT_EQ(26, test.testRepeatedComplex().at(1)->testFieldInt());
+    ASSERT_TRUE(test.testRepeatedComplex().at(1)->testComplexField().testFieldString() == QString("qwerty"));
+    ASSERT_EQ(0, notifications);
+
+    //Elements return to their pool when released, but pool is used for allocation only while its scope is active
+    test.setTestRepeatedComplex({});
+    test.deserialize(serializer.get(), data);
+    ASSERT_EQ(2, pool.count());
+    pool.clear();
+    ASSERT_EQ(0, pool.count());
+
+    //Elements released after pool is destroyed are deleted
+    {
+        QProtobufMessagePool localPool;
+        QProtobufMessagePool::Scope scope(&localPool);
+        test.deserialize(serializer.get(), data);
+    }
+    ASSERT_EQ(2, test.testRepeatedComplex().count());
+    test.setTestRepeatedComplex({});
+}
+
+TEST_F(DeserializationTest, DeserializeIntoTest)
+{
+    ComplexMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("1208320671776572747908d3ffffffffffffffff01"));
+
+    serializer->deserializeInto(&test, QByteArray::fromHex("082a"));
+    ASSERT_EQ(42, test.testFieldInt());
+    ASSERT_TRUE(test.testComplexField().testFieldString().isEmpty());
+
+    RepeatedIntMessage repeatedTest;
+    repeatedTest.deserialize(serializer.get(), QByteArray::fromHex("0a03010203"));
+    serializer->deserializeInto(&repeatedTest, QByteArray::fromHex("0a020405"));
+    ASSERT_TRUE(repeatedTest.testRepeatedInt() == int32List({4, 5}));
+}
+
+TEST_F(DeserializationTest, BatchedNotifyTest)
+{
+    RepeatedIntMessage test;
+    int notifyCount = 0;
+    QObject::connect(&test, &RepeatedIntMessage::testRepeatedIntChanged, [&notifyCount]() {
+        ++notifyCount;
+    });
+
+    //Elements of repeated field are written to message once
+    serializer->mergeFrom(&test, QByteArray::fromHex("0a0201020a020304"));
+    ASSERT_EQ(1, notifyCount);
+    ASSERT_TRUE(test.testRepeatedInt() == int32List({1, 2, 3, 4}));
+
+    notifyCount = 0;
+    serializer->setOptions(QProtobufSerializer::BatchedNotify);
+    serializer->mergeFrom(&test, QByteArray::fromHex("0a0201020a020304"));
+    ASSERT_EQ(1, notifyCount);
+    ASSERT_TRUE(test.testRepeatedInt() == int32List({1, 2, 3, 4, 1, 2, 3, 4}));
+    ASSERT_FALSE(test.signalsBlocked());
+
+    notifyCount = 0;
+    serializer->deserializeInto(&test, QByteArray());
+    ASSERT_EQ(1, notifyCount);
+    ASSERT_TRUE(test.testRepeatedInt().isEmpty());
+}
+
+TEST_F(DeserializationTest, RepeatedFieldsAccumulationTest)
+{
+    RepeatedStringMessage test;
+    int notifyCount = 0;
+    QObject::connect(&test, &RepeatedStringMessage::testRepeatedStringChanged, [&notifyCount]() {
+        ++notifyCount;
+    });
+
+    QByteArray data;
+    for (int i = 0; i < 1000; i++) {
+        data.append(QByteArray::fromHex("0a0161"));
+    }
+    test.deserialize(serializer.get(), data);
+    ASSERT_EQ(1000, test.testRepeatedString().count());
+    ASSERT_EQ(1, notifyCount);
+
+    SimpleSInt32StringMapMessage mapTest;
+    QByteArray mapData;
+    for (int i = 0; i < 64; i++) {
+        mapData.append(QByteArray::fromHex("0a0508"));
+        mapData.append(static_cast<char>(i * 2));
+        mapData.append(QByteArray::fromHex("120176"));
+    }
+    mapTest.deserialize(serializer.get(), mapData);
+    ASSERT_EQ(64, mapTest.mapField().count());
+    ASSERT_EQ(QString("v"), mapTest.mapField()[63]);
+}
@@ -67,5 +67,42 @@ TEST_F(InternalsTest, NullPointerGetterMessageTest)
     ASSERT_TRUE(msg.testComplexField_p() != nullptr);
 }
 
+TEST_F(InternalsTest, FieldsTableOrderTest)
+{
+    const auto &fields = ComplexMessage::protobufMetaObject.fields();
+    ASSERT_EQ(2u, fields.size());
+    ASSERT_EQ(1, fields[0].metaProperty.protoFieldIndex());
+    ASSERT_STREQ("testFieldInt", fields[0].metaProperty.name());
+    ASSERT_EQ(2, fields[1].metaProperty.protoFieldIndex());
+    ASSERT_STREQ("testComplexField", fields[1].metaProperty.name());
+}
+
+TEST_F(InternalsTest, FieldsTableLookupTest)
+{
+    const QProtobufFieldInfo *field = ComplexMessage::protobufMetaObject.field(2);
+    ASSERT_TRUE(field != nullptr);
+    ASSERT_STREQ("testComplexField", field->metaProperty.name());
+    ASSERT_TRUE(ComplexMessage::protobufMetaObject.field(0) == nullptr);
+    ASSERT_TRUE(ComplexMessage::protobufMetaObject.field(3) == nullptr);
+    ASSERT_TRUE(ComplexMessage::protobufMetaObject.field(-1) == nullptr);
+
+    //Sparse field numbers are looked up using binary search
+    field = FieldIndexTest4Message::protobufMetaObject.field(536870911);
+    ASSERT_TRUE(field != nullptr);
+    ASSERT_STREQ("testField", field->metaProperty.name());
+    ASSERT_TRUE(FieldIndexTest4Message::protobufMetaObject.field(1) == nullptr);
+}
+
+TEST_F(InternalsTest, HandlersRegistryLookupTest)
+{
+    QtProtobuf::qRegisterProtobufTypes();
+    const QtProtobufPrivate::SerializationHandler *handler = QtProtobufPrivate::findHandler(qMetaTypeId<ComplexMessage *>());
+    ASSERT_TRUE(handler != nullptr);
+    ASSERT_EQ(QtProtobufPrivate::ObjectHandler, handler->type);
+    ASSERT_EQ(handler, QtProtobufPrivate::findHandler(qMetaTypeId<ComplexMessage *>()));
+    ASSERT_TRUE(QtProtobufPrivate::findHandler(QMetaType::QRect) == nullptr);
+    ASSERT_TRUE(QtProtobufPrivate::findHandler(-1) == nullptr);
+}
+
 }
 }
@@ -26,8 +26,11 @@
 #include <gtest/gtest.h>
 #include <QByteArray>
 #include <QString>
+#include <QBuffer>
 
 #include <qprotobufjsonserializer.h>
+#include <qprotobufjsonlines.h>
+#include <qprotobufmetaobject.h>
 
 #include "simpletest.qpb.h"
 
@@ -186,15 +189,15 @@ TEST_F(JsonDeserializationTest, FloatMessageSerializeTest)
 
     test.setTestFieldFloat(-4.2f);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldFloat\":\"NaN\"}"));
-    EXPECT_EQ(test.testFieldFloat(), 0);
+    EXPECT_TRUE(qIsNaN(test.testFieldFloat()));
 
     test.setTestFieldFloat(-4.2f);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldFloat\":\"Infinity\"}"));
-    EXPECT_EQ(test.testFieldFloat(), 0);
+    EXPECT_EQ(test.testFieldFloat(), static_cast<float>(qInf()));
 
     test.setTestFieldFloat(-4.2f);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldFloat\":\"-Infinity\"}"));
-    EXPECT_EQ(test.testFieldFloat(), 0);
+    EXPECT_EQ(test.testFieldFloat(), static_cast<float>(-qInf()));
 }
 
 TEST_F(JsonDeserializationTest, DoubleMessageSerializeTest)
@@ -221,15 +224,42 @@ TEST_F(JsonDeserializationTest, DoubleMessageSerializeTest)
 
     test.setTestFieldDouble(-4.2);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldDouble\":\"NaN\"}"));
-    EXPECT_EQ(test.testFieldDouble(), 0);
+    EXPECT_TRUE(qIsNaN(test.testFieldDouble()));
 
     test.setTestFieldDouble(-4.2);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldDouble\":\"Infinity\"}"));
-    EXPECT_EQ(test.testFieldDouble(), 0);
+    EXPECT_EQ(test.testFieldDouble(), static_cast<double>(qInf()));
 
     test.setTestFieldDouble(-4.2);
     test.deserialize(serializer.get(), QByteArray("{\"testFieldDouble\":\"-Infinity\"}"));
-    EXPECT_EQ(test.testFieldDouble(), 0);
+    EXPECT_EQ(test.testFieldDouble(), static_cast<double>(-qInf()));
+}
+
+TEST_F(JsonDeserializationTest, SpecialValuesRoundTripTest)
+{
+    SimpleDoubleMessage doubleTest;
+    SimpleDoubleMessage doubleResult;
+    doubleTest.setTestFieldDouble(qQNaN());
+    doubleResult.deserialize(serializer.get(), doubleTest.serialize(serializer.get()));
+    EXPECT_TRUE(qIsNaN(doubleResult.testFieldDouble()));
+
+    doubleTest.setTestFieldDouble(qInf());
+    doubleResult.deserialize(serializer.get(), doubleTest.serialize(serializer.get()));
+    EXPECT_EQ(doubleResult.testFieldDouble(), qInf());
+
+    doubleTest.setTestFieldDouble(-qInf());
+    doubleResult.deserialize(serializer.get(), doubleTest.serialize(serializer.get()));
+    EXPECT_EQ(doubleResult.testFieldDouble(), -qInf());
+
+    SimpleFloatMessage floatTest;
+    SimpleFloatMessage floatResult;
+    floatTest.setTestFieldFloat(static_cast<float>(qQNaN()));
+    floatResult.deserialize(serializer.get(), floatTest.serialize(serializer.get()));
+    EXPECT_TRUE(qIsNaN(floatResult.testFieldFloat()));
+
+    floatTest.setTestFieldFloat(static_cast<float>(-qInf()));
+    floatResult.deserialize(serializer.get(), floatTest.serialize(serializer.get()));
+    EXPECT_EQ(floatResult.testFieldFloat(), static_cast<float>(-qInf()));
 }
 
 TEST_F(JsonDeserializationTest, StringMessageSerializeTest)
@@ -245,6 +275,13 @@ TEST_F(JsonDeserializationTest, StringMessageSerializeTest)
     test.deserialize(serializer.get(), QByteArray("{\"testFieldString\":null}"));
     EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "");
 
+    test.deserialize(serializer.get(), QByteArray("{\"testFieldString\":\"quote\\\" backslash\\\\ tab\\t line\\n bell\\u0007 \\u00e9\\ud83d\\ude00\"}"));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "quote\" backslash\\ tab\t line\n bell\x07 \xc3\xa9\xf0\x9f\x98\x80");
+
+    //Invalid UTF-8 is rejected
+    test.deserialize(serializer.get(), QByteArray("{\"testFieldString\":\"qwerty\xc0\x80\"}"));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "");
+
     test.deserialize(serializer.get(), QByteArray("{\"testFieldString\":\"null\"}"));
     EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "null");
 
@@ -270,6 +307,15 @@ TEST_F(JsonDeserializationTest, BytesMessageSerializeTest)
     test.setTestFieldBytes("qwerty");
     test.deserialize(serializer.get(), QByteArray("{\"testFieldBytes\":null}"));
     EXPECT_TRUE(test.testFieldBytes().isEmpty());
+
+    test.deserialize(serializer.get(), QByteArray("{\"testFieldBytes\":\"cXdlcnQ\"}"));
+    EXPECT_STREQ(test.testFieldBytes().toStdString().c_str(), "qwert");
+
+    test.deserialize(serializer.get(), QByteArray("{\"testFieldBytes\":\"-_-_+/+/\"}"));
+    EXPECT_STREQ(test.testFieldBytes().toHex().toStdString().c_str(), "fbffbffbffbf");
+
+    test.deserialize(serializer.get(), QByteArray("{\"testFieldBytes\":\"cXd$cnR5\"}"));
+    EXPECT_TRUE(test.testFieldBytes().isEmpty());
 }
 
 TEST_F(JsonDeserializationTest, ComplexTypeSerializeTest)
@@ -316,6 +362,26 @@ TEST_F(JsonDeserializationTest, ComplexTypeSerializeTest)
 
 }
 
+TEST_F(JsonDeserializationTest, FieldNameLookupTest)
+{
+    const QProtobufFieldInfo *field = ComplexMessage::protobufMetaObject.fieldByJsonName("testFieldInt", 12);
+    ASSERT_TRUE(field != nullptr);
+    EXPECT_EQ(1, field->metaProperty.protoFieldIndex());
+
+    //Name is not required to be null-terminated
+    field = ComplexMessage::protobufMetaObject.fieldByJsonName("testComplexFieldSuffix", 16);
+    ASSERT_TRUE(field != nullptr);
+    EXPECT_EQ(2, field->metaProperty.protoFieldIndex());
+
+    EXPECT_TRUE(ComplexMessage::protobufMetaObject.fieldByJsonName("testField", 9) == nullptr);
+    EXPECT_TRUE(ComplexMessage::protobufMetaObject.fieldByJsonName("", 0) == nullptr);
+
+    //Unknown properties are skipped
+    ComplexMessage test;
+    test.deserialize(serializer.get(), QByteArray("{\"unknownField\":1,\"testFieldInt\":42,\"testField\":2}"));
+    EXPECT_EQ(test.testFieldInt(), 42);
+}
+
 TEST_F(JsonDeserializationTest, RepeatedIntMessageTest)
 {
     RepeatedIntMessage test;
@@ -595,6 +661,42 @@ TEST_F(JsonDeserializationTest, RepeatedComplexMessageTest)
     EXPECT_TRUE(test.testRepeatedComplex().isEmpty());
 }
 
+TEST_F(JsonDeserializationTest, StructuralCharactersTest)
+{
+    RepeatedComplexMessage test;
+    test.deserialize(serializer.get(), "{ \"testRepeatedComplex\" : [ {\"testComplexField\" : {\"testFieldString\":\"{[\\\"qwerty\\\",]}:\"} ,\n"
+                                       "\"testFieldInt\" : 25 } ,\n"
+                                       "{\"unknownField\":{\"a\":[1,{\"b\":\"]}\\\\\"}]},\"testFieldInt\":-26}\t]\n}");
+    ASSERT_EQ(test.testRepeatedComplex().size(), 2);
+    EXPECT_EQ(test.testRepeatedComplex()[0]->testFieldInt(), 25);
+    EXPECT_STREQ(test.testRepeatedComplex()[0]->testComplexField().testFieldString().toStdString().c_str(), "{[\"qwerty\",]}:");
+    EXPECT_EQ(test.testRepeatedComplex()[1]->testFieldInt(), -26);
+
+    //Unbalanced document is rejected
+    EXPECT_FALSE(test.tryDeserialize(serializer.get(), "{\"testRepeatedComplex\":[{\"testFieldInt\":25}}"));
+    EXPECT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+    EXPECT_FALSE(serializer->deserializationErrorString().isEmpty());
+    EXPECT_TRUE(test.testRepeatedComplex().isEmpty());
+    EXPECT_THROW(test.deserialize(serializer.get(), "{\"testRepeatedComplex\":[{\"testFieldInt\":25}}"), std::invalid_argument);
+
+    //Message that is not json object is rejected
+    EXPECT_FALSE(test.tryDeserialize(serializer.get(), "[1,2]"));
+    EXPECT_FALSE(test.tryDeserialize(serializer.get(), "{\"testRepeatedComplex\":[25]}"));
+    EXPECT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+
+    //Member without value is rejected
+    EXPECT_FALSE(test.tryDeserialize(serializer.get(), "{\"testRepeatedComplex\": }"));
+    EXPECT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+    EXPECT_FALSE(test.tryDeserialize(serializer.get(), "{\"testRepeatedComplex\":[{\"testFieldInt\":}]}"));
+    EXPECT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+    EXPECT_THROW(test.deserialize(serializer.get(), "{\"testRepeatedComplex\": }"), std::invalid_argument);
+
+    EXPECT_TRUE(test.tryDeserialize(serializer.get(), "{ }"));
+    EXPECT_TRUE(test.tryDeserialize(serializer.get(), "{\"testRepeatedComplex\":[{\"testFieldInt\":25}]}"));
+    EXPECT_EQ(QAbstractProtobufSerializer::NoError, serializer->deserializationError());
+    EXPECT_EQ(test.testRepeatedComplex().size(), 1);
+}
+
 TEST_F(JsonDeserializationTest, SimpleFixed32StringMapSerializeTest)
 {
     SimpleFixed32StringMapMessage test;
@@ -744,5 +846,66 @@ TEST_F(JsonDeserializationTest, SimpleStringStringMapSerializeTest)
     ASSERT_EQ(test.mapField().size(), 0);
 }
 
+TEST_F(JsonDeserializationTest, JsonLinesReaderTest)
+{
+    QProtobufJsonLinesReader reader(serializer.get());
+    SimpleStringMessage test;
+
+    reader.feed("{\"testFieldString\":\"qwerty\"}\n{\"testFieldSt");
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "qwerty");
+    EXPECT_EQ(QProtobufJsonLinesReader::NoMessage, reader.read(&test));
+    EXPECT_EQ(reader.pendingSize(), 13);
+
+    reader.feed("ring\":\"line\\nbreak\"}\r\n\n{}\n{\"testFieldString\":\"last\"}");
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "line\nbreak");
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_TRUE(test.testFieldString().isEmpty());
+    EXPECT_EQ(QProtobufJsonLinesReader::NoMessage, reader.read(&test));
+
+    reader.finish();
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "last");
+    EXPECT_EQ(QProtobufJsonLinesReader::NoMessage, reader.read(&test));
+    EXPECT_EQ(reader.pendingSize(), 0);
+}
+
+TEST_F(JsonDeserializationTest, JsonLinesReaderMalformedTest)
+{
+    QProtobufJsonLinesReader reader(serializer.get());
+    SimpleStringMessage test;
+
+    reader.feed("{\"testFieldString\":\"first\"}\n{\"testFieldString\":\"\n[garbage\n{\"testFieldString\":\"last\"}\n");
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "first");
+    ASSERT_EQ(QProtobufJsonLinesReader::MalformedMessage, reader.read(&test));
+    EXPECT_EQ(QAbstractProtobufSerializer::InvalidFormatError, serializer->deserializationError());
+    ASSERT_EQ(QProtobufJsonLinesReader::MalformedMessage, reader.read(&test));
+    ASSERT_EQ(QProtobufJsonLinesReader::MessageRead, reader.read(&test));
+    EXPECT_STREQ(test.testFieldString().toStdString().c_str(), "last");
+    EXPECT_EQ(QProtobufJsonLinesReader::NoMessage, reader.read(&test));
+}
+
+TEST_F(JsonDeserializationTest, JsonLinesReaderDeviceTest)
+{
+    QByteArray data;
+    for (int i = 0; i < 10000; ++i) {
+        data.append("{\"testFieldInt\":" + QByteArray::number(i) + "}\n");
+    }
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QProtobufJsonLinesReader reader(serializer.get(), &buffer);
+    SimpleIntMessage test;
+    int count = 0;
+    while (reader.read(&test) == QProtobufJsonLinesReader::MessageRead) {
+        ASSERT_EQ(test.testFieldInt(), count);
+        ++count;
+    }
+    EXPECT_EQ(count, 10000);
+    EXPECT_EQ(reader.pendingSize(), 0);
+}
+
 }
 }
@@ -26,8 +26,10 @@
 #include <gtest/gtest.h>
 #include <QByteArray>
 #include <QString>
+#include <QBuffer>
 
 #include <qprotobufjsonserializer.h>
+#include <qprotobufjsonlines.h>
 
 #include "simpletest.qpb.h"
 
@@ -148,11 +150,11 @@ TEST_F(JsonSerializationTest, FloatMessageSerializeTest)
 
     test.setTestFieldFloat(FLT_MIN);
     result = test.serialize(serializer.get());
-    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldFloat\":1.17549e-38}");
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldFloat\":1.1754944e-38}");
 
     test.setTestFieldFloat(FLT_MAX);
     result = test.serialize(serializer.get());
-    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldFloat\":3.40282e+38}");
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldFloat\":3.4028235e+38}");
 
     test.setTestFieldFloat(-4.2f);
     result = test.serialize(serializer.get());
@@ -187,12 +189,34 @@ TEST_F(JsonSerializationTest, DoubleMessageSerializeTest)
     EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldDouble\":0}");
 }
 
+TEST_F(JsonSerializationTest, OutputCapacityTest)
+{
+    SimpleStringMessage test;
+    test.setTestFieldString(QString(1024 * 1024, QLatin1Char('a')));
+    QByteArray result = test.serialize(serializer.get());
+    ASSERT_GT(result.size(), 1024 * 1024);
+
+    //Big message doesn't inflate output of following small ones
+    test.setTestFieldString(QStringLiteral("qwerty"));
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldString\":\"qwerty\"}");
+    EXPECT_LT(result.capacity(), 256);
+}
+
 TEST_F(JsonSerializationTest, StringMessageSerializeTest)
 {
     SimpleStringMessage test;
     test.setTestFieldString("qwerty");
     QByteArray result = test.serialize(serializer.get());
     EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldString\":\"qwerty\"}");
+
+    test.setTestFieldString(QString::fromUtf8("quote\" backslash\\ tab\t line\n bell\x07 end"));
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldString\":\"quote\\\" backslash\\\\ tab\\t line\\n bell\\u0007 end\"}");
+
+    test.setTestFieldString(QString::fromUtf8("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82\""));
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldString\":\"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82\\\"\"}");
 }
 
 TEST_F(JsonSerializationTest, BytesMessageSerializeTest)
@@ -201,6 +225,18 @@ TEST_F(JsonSerializationTest, BytesMessageSerializeTest)
     test.setTestFieldBytes(QByteArray::fromHex("0012840432810459560052664a766a78716267764677533159764f5a5867746a356666474c53374001694e487a396f5a496f4b626d377a38480137397842757009506b70515876476f4f30394f5939785261777833654f417339786a6f544131784a68727732385441637131436562596c43395755665143366849616e74614e647948694b546f666669305a74376c613432535278585a53503447757862635a49703533704a6e79437766437931716446637a5430646d6e3768386670794164656d456176774665646134643050417047665355326a4c74333958386b595542784e4d325767414c524267486456646538377136506935553639546a684d6432385731534644314478796f67434372714f6374325a5049436f4c6e72716446334f644e7a6a52564c6665797651384c674c76524e4652395766574179417a37396e4b6742616d64384e746c7674344d6733354535675653326737415137726b6d37326342646e5739734345794761626558417548356a34475262754c543771425a574463464c463453734364533357664647644e48667761696a7a796b42796f3731507646566c54584832574a576f4676523546414c6a42546e37624364503070416953624c435938587a324d73633364426235466639474953506255704e6d557642644d5a4d485176714f6d544e584550704e306237344d444f4d5166574a53684f6f334e6b41764d6a73082a"));
     QByteArray result = test.serialize(serializer.get());
     EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldBytes\":\"ABKEBDKBBFlWAFJmSnZqeHFiZ3ZGd1MxWXZPWlhndGo1ZmZHTFM3QAFpTkh6OW9aSW9LYm03ejhIATc5eEJ1cAlQa3BRWHZHb08wOU9ZOXhSYXd4M2VPQXM5eGpvVEExeEpocncyOFRBY3ExQ2ViWWxDOVdVZlFDNmhJYW50YU5keUhpS1RvZmZpMFp0N2xhNDJTUnhYWlNQNEd1eGJjWklwNTNwSm55Q3dmQ3kxcWRGY3pUMGRtbjdoOGZweUFkZW1FYXZ3RmVkYTRkMFBBcEdmU1Uyakx0MzlYOGtZVUJ4Tk0yV2dBTFJCZ0hkVmRlODdxNlBpNVU2OVRqaE1kMjhXMVNGRDFEeHlvZ0NDcnFPY3QyWlBJQ29MbnJxZEYzT2ROempSVkxmZXl2UThMZ0x2Uk5GUjlXZldBeUF6NzluS2dCYW1kOE50bHZ0NE1nMzVFNWdWUzJnN0FRN3JrbTcyY0Jkblc5c0NFeUdhYmVYQXVINWo0R1JidUxUN3FCWldEY0ZMRjRTc0NkUzNXZkZHZE5IZndhaWp6eWtCeW83MVB2RlZsVFhIMldKV29GdlI1RkFMakJUbjdiQ2RQMHBBaVNiTENZOFh6Mk1zYzNkQmI1RmY5R0lTUGJVcE5tVXZCZE1aTUhRdnFPbVROWEVQcE4wYjc0TURPTVFmV0pTaE9vM05rQXZNanMIKg==\"}");
+
+    test.setTestFieldBytes("q");
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldBytes\":\"cQ==\"}");
+
+    test.setTestFieldBytes("qw");
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldBytes\":\"cXc=\"}");
+
+    test.setTestFieldBytes("qwerty1");
+    result = test.serialize(serializer.get());
+    EXPECT_STREQ(QString::fromUtf8(result).toStdString().c_str(), "{\"testFieldBytes\":\"cXdlcnR5MQ==\"}");
 }
 
 TEST_F(JsonSerializationTest, ComplexTypeSerializeTest)
@@ -574,5 +610,30 @@ TEST_F(JsonSerializationTest, SimpleStringStringMapSerializeTest)
                  "{\"mapField\":{\"ben\":\"ten\",\"sweet\":\"fifteen\",\"what is the answer?\":\"fourty two\"}}");
 }
 
+TEST_F(JsonSerializationTest, JsonLinesWriterTest)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QProtobufJsonLinesWriter writer(serializer.get(), &buffer);
+
+    SimpleStringMessage test;
+    test.setTestFieldString("qwerty");
+    EXPECT_TRUE(writer.write(&test));
+    test.setTestFieldString("line\nbreak");
+    EXPECT_TRUE(writer.write(&test));
+
+    QList<QSharedPointer<SimpleStringMessage>> list;
+    list.append(QSharedPointer<SimpleStringMessage>(new SimpleStringMessage));
+    list.append(QSharedPointer<SimpleStringMessage>(new SimpleStringMessage));
+    list.last()->setTestFieldString("last");
+    EXPECT_TRUE(writer.write(list));
+
+    EXPECT_EQ(writer.count(), 4);
+    EXPECT_STREQ(buffer.data().toStdString().c_str(), "{\"testFieldString\":\"qwerty\"}\n"
+                                                      "{\"testFieldString\":\"line\\nbreak\"}\n"
+                                                      "{\"testFieldString\":\"\"}\n"
+                                                      "{\"testFieldString\":\"last\"}\n");
+}
+
 }
 }
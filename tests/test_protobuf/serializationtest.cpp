@@ -27,6 +27,8 @@
 
 #include "simpletest.qpb.h"
 
+#include <QBuffer>
+
 using namespace qtprotobufnamespace::tests;
 using namespace QtProtobuf::tests;
 using namespace QtProtobuf;
@@ -877,6 +879,19 @@ TEST_F(SerializationTest, StringMessageSerializeTest)
     ASSERT_STREQ(result.toHex().toStdString().c_str(), "3280046f6570534e4c4956473038554a706b3257374a74546b6b4278794b303658306c51364d4c37494d6435354b3858433154707363316b4457796d3576387a3638623446517570394f393551536741766a48494131354f583642753638657362514654394c507a5341444a367153474254594248583551535a67333274724364484d6a383058754448717942674d34756636524b71326d675762384f76787872304e774c786a484f66684a384d726664325237686255676a65737062596f5168626748456a32674b45563351766e756d596d7256586531426b437a5a684b56586f6444686a304f6641453637766941793469334f6167316872317a34417a6f384f3558713638504f455a3143735a506f3244584e4e52386562564364594f7a3051364a4c50536c356a61734c434672514e374569564e6a516d437253735a4852674c4e796c76676f454678475978584a39676d4b346d72304f47645a63474a4f5252475a4f514370514d68586d68657a46616c4e494a584d50505861525658695268524150434e55456965384474614357414d717a346e4e5578524d5a355563584258735850736879677a6b7979586e4e575449446f6a466c7263736e4b71536b5131473645383567535a6274495942683773714f36474458486a4f72585661564356435575626a634a4b54686c79736c7432397a48754973354a47707058785831");
 }
 
+TEST_F(SerializationTest, StringMessageUtf8SerializeTest)
+{
+    SimpleStringMessage test;
+    test.setTestFieldString(QString::fromUtf8("Привет 🙂"));
+    QByteArray result = test.serialize(serializer.get());
+    ASSERT_STREQ(result.toHex().toStdString().c_str(), "3211d09fd180d0b8d0b2d0b5d18220f09f9982");
+
+    //Unpaired surrogate is replaced with '?' same as QString::toUtf8 does
+    test.setTestFieldString(QString(QChar(0xd83d)) + QString("a"));
+    result = test.serialize(serializer.get());
+    ASSERT_STREQ(result.toHex().toStdString().c_str(), "32023f61");
+}
+
 TEST_F(SerializationTest, ComplexTypeSerializeTest)
 {
     SimpleStringMessage stringMsg;
@@ -923,6 +938,31 @@ TEST_F(SerializationTest, RepeatedIntMessageTest)
     ASSERT_TRUE(result.isEmpty());
 }
 
+TEST_F(SerializationTest, RepeatedUIntMessageLengthPrefixTest)
+{
+    RepeatedUIntMessage test;
+    uint32List list;
+    for (int i = 0; i < 127; i++) {
+        list.append(1);
+    }
+    test.setTestRepeatedInt(list);
+    QByteArray result = test.serialize(serializer.get());
+    ASSERT_EQ(129, result.size());
+    ASSERT_TRUE(result.startsWith(QByteArray::fromHex("0a7f01")));
+
+    //Length prefix of list longer than 127 bytes takes two bytes
+    list.append(321);
+    test.setTestRepeatedInt(list);
+    result = test.serialize(serializer.get());
+    ASSERT_EQ(132, result.size());
+    ASSERT_TRUE(result.startsWith(QByteArray::fromHex("0a810101")));
+    ASSERT_TRUE(result.endsWith(QByteArray::fromHex("01c102")));
+
+    RepeatedUIntMessage test2;
+    test2.deserialize(serializer.get(), result);
+    ASSERT_TRUE(test2.testRepeatedInt() == list);
+}
+
 TEST_F(SerializationTest, RepeatedSIntMessageTest)
 {
     RepeatedSIntMessage test;
@@ -1302,6 +1342,144 @@ TEST_F(SerializationTest, EmptyStringMessageTest)
     ASSERT_TRUE(result.isEmpty());
 }
 
+TEST_F(SerializationTest, SerializeToDeviceTest)
+{
+    ComplexMessage test;
+    test.setTestFieldInt(-45);
+    test.setTestComplexField(SimpleStringMessage{"qwerty"});
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    ASSERT_TRUE(test.serialize(serializer.get(), &buffer));
+    ASSERT_TRUE(buffer.data() == test.serialize(serializer.get()));
+
+    //Message is bigger than output chunk, so it's written by several chunks
+    RepeatedStringMessage repeatedTest;
+    QStringList strings;
+    for (int i = 0; i < 10000; i++) {
+        strings.append(QString("string%1").arg(i));
+    }
+    repeatedTest.setTestRepeatedString(strings);
+
+    QBuffer repeatedBuffer;
+    repeatedBuffer.open(QIODevice::WriteOnly);
+    ASSERT_TRUE(repeatedTest.serialize(serializer.get(), &repeatedBuffer));
+    ASSERT_TRUE(repeatedBuffer.data() == repeatedTest.serialize(serializer.get()));
+
+    QBuffer closedBuffer;
+    ASSERT_FALSE(test.serialize(serializer.get(), &closedBuffer));
+}
+
+TEST_F(SerializationTest, SerializedSizeTest)
+{
+    ComplexMessage test;
+    ASSERT_EQ(0, test.serializedSize(serializer.get()));
+
+    test.setTestFieldInt(-45);
+    test.setTestComplexField(SimpleStringMessage{"qwerty"});
+    ASSERT_EQ(test.serialize(serializer.get()).size(), test.serializedSize(serializer.get()));
+
+    RepeatedStringMessage repeatedTest;
+    QStringList strings;
+    for (int i = 0; i < 1000; i++) {
+        strings.append(QString("string%1").arg(i));
+    }
+    repeatedTest.setTestRepeatedString(strings);
+    ASSERT_EQ(repeatedTest.serialize(serializer.get()).size(), repeatedTest.serializedSize(serializer.get()));
+
+    SimpleStringStringMapMessage mapTest;
+    mapTest.setMapField({{"key1", "value1"}, {"key2", "value2"}});
+    ASSERT_EQ(mapTest.serialize(serializer.get()).size(), mapTest.serializedSize(serializer.get()));
+}
+
+TEST_F(SerializationTest, DeterministicSerializationTest)
+{
+    //Fields are written in order of field numbers regardless of order in input
+    ComplexMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("1208320671776572747908d3ffffffffffffffff01"));
+    serializer->setOptions(QProtobufSerializer::Deterministic);
+    ASSERT_STREQ(test.serialize(serializer.get()).toHex().toStdString().c_str(), "08d3ffffffffffffffff0112083206717765727479");
+
+    //Unknown fields are written in order of field numbers
+    SimpleIntMessage unknownTest;
+    unknownTest.deserialize(serializer.get(), QByteArray::fromHex("0896011a020801200112057177657274");
+    ASSERT_STREQ(unknownTest.serialize(serializer.get()).toHex().toStdString().c_str(), "089601120571776572741a0208012001");
+    ASSERT_EQ(unknownTest.serialize(serializer.get()).size(), unknownTest.serializedSize(serializer.get()));
+
+    //Nested message kept serialized is re-encoded
+    serializer->setOptions(QProtobufSerializer::LazyMessages);
+    ComplexMessage lazyTest;
+    lazyTest.deserialize(serializer.get(), QByteArray::fromHex("08d3ffffffffffffffff01120b3201613206717765727479"));
+    ASSERT_STREQ(lazyTest.serialize(serializer.get()).toHex().toStdString().c_str(), "08d3ffffffffffffffff01120b3201613206717765727479");
+    serializer->setOptions(QProtobufSerializer::LazyMessages | QProtobufSerializer::Deterministic);
+    ASSERT_EQ(21, lazyTest.serializedSize(serializer.get()));
+    ASSERT_STREQ(lazyTest.serialize(serializer.get()).toHex().toStdString().c_str(), "08d3ffffffffffffffff0112083206717765727479");
+}
+
+TEST_F(SerializationTest, FieldMaskSerializationTest)
+{
+    ComplexMessage test;
+    test.setTestFieldInt(-45);
+    test.setTestComplexField(SimpleStringMessage{"qwerty"});
+
+    ASSERT_STREQ(test.serialize(serializer.get(), QProtobufFieldMask{{1}}).toHex().toStdString().c_str(), "08d3ffffffffffffffff01");
+    ASSERT_STREQ(test.serialize(serializer.get(), QProtobufFieldMask{{2}}).toHex().toStdString().c_str(), "12083206717765727479");
+    ASSERT_STREQ(test.serialize(serializer.get(), QProtobufFieldMask{{2, 6}}).toHex().toStdString().c_str(), "12083206717765727479");
+    ASSERT_STREQ(test.serialize(serializer.get(), QProtobufFieldMask{{2, 7}}).toHex().toStdString().c_str(), "1200");
+    ASSERT_TRUE(test.serialize(serializer.get(), QProtobufFieldMask::all()) == test.serialize(serializer.get()));
+    ASSERT_TRUE(test.serialize(serializer.get(), QProtobufFieldMask()).isEmpty());
+
+    QProtobufFieldMask mask = QProtobufFieldMask::fromPaths({"test_field_int", "testComplexField.testFieldString"}, ComplexMessage::protobufMetaObject);
+    ASSERT_TRUE(mask.contains(1));
+    ASSERT_TRUE(mask.contains(2));
+    ASSERT_FALSE(mask.contains(3));
+    ASSERT_TRUE(test.serialize(serializer.get(), mask) == test.serialize(serializer.get()));
+
+    //Mask with unresolved path selects no fields
+    bool ok = true;
+    mask = QProtobufFieldMask::fromPaths({"test_field_int", "unknownField"}, ComplexMessage::protobufMetaObject, &ok);
+    ASSERT_FALSE(ok);
+    ASSERT_FALSE(mask.isValid());
+    ASSERT_FALSE(mask.contains(1));
+    ASSERT_TRUE(test.serialize(serializer.get(), mask).isEmpty());
+}
+
+TEST_F(SerializationTest, FieldMaskRepeatedSerializationTest)
+{
+    QSharedPointer<ComplexMessage> msg(new ComplexMessage);
+    msg->setTestFieldInt(25);
+    msg->setTestComplexField(SimpleStringMessage{"qwerty"});
+    RepeatedComplexMessage test;
+    test.setTestRepeatedComplex({msg, msg});
+
+    bool ok = false;
+    QProtobufFieldMask mask = QProtobufFieldMask::fromPaths({"testRepeatedComplex.testComplexField"}, RepeatedComplexMessage::protobufMetaObject, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(mask.isValid());
+    ASSERT_STREQ(test.serialize(serializer.get(), mask).toHex().toStdString().c_str(), "0a0a120832067177657274790a0a12083206717765727479");
+
+    //Sub-paths of map fields are resolved using message type of values
+    mask = QProtobufFieldMask::fromPaths({"map_field.test_field_int"}, SimpleSInt32ComplexMessageMapMessage::protobufMetaObject, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(mask.contains(1));
+}
+
+TEST_F(SerializationTest, SerializeBatchTest)
+{
+    QList<QSharedPointer<ComplexMessage>> messages;
+    for (int i = 0; i < 1000; i++) {
+        messages.append(QSharedPointer<ComplexMessage>(new ComplexMessage(i, SimpleStringMessage{QString("string%1").arg(i)})));
+    }
+
+    QList<QByteArray> result = serializer->serializeBatch(messages);
+    ASSERT_EQ(messages.size(), result.size());
+    for (int i = 0; i < messages.size(); i++) {
+        ASSERT_TRUE(result.at(i) == messages.at(i)->serialize(serializer.get()));
+    }
+
+    ASSERT_TRUE(serializer->serializeBatch(QList<QSharedPointer<ComplexMessage>>()).isEmpty());
+}
+
 TEST_F(SerializationTest, DISABLED_BenchmarkTest)
 {
     qtprotobufnamespace::tests::SimpleIntMessage msg;
@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Alexey Edelev <semlanik@gmail.com>
+ *
+ * This file is part of QtProtobuf project https://git.semlanik.org/semlanik/qtprotobuf
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ * to permit persons to whom the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "simpletest.qpb.h"
+
+#include <qprotobufserializer.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtprotobufnamespace::tests;
+
+namespace QtProtobuf {
+namespace tests {
+
+class TypedSerializerTest : public ::testing::Test
+{
+public:
+    TypedSerializerTest() = default;
+    void SetUp() override {
+        serializer.reset(new QProtobufSerializer);
+    }
+    static void SetUpTestCase() {
+        QtProtobuf::qRegisterProtobufTypes();
+    }
+protected:
+    std::unique_ptr<QProtobufSerializer> serializer;
+};
+
+TEST_F(TypedSerializerTest, TypedSerializersGeneratedTest)
+{
+    ASSERT_TRUE(SimpleIntMessage::protobufMetaObject.typedSerializer != nullptr);
+    ASSERT_TRUE(SimpleIntMessage::protobufMetaObject.typedDeserializer != nullptr);
+    ASSERT_TRUE(ComplexMessage::protobufMetaObject.typedSerializer != nullptr);
+    ASSERT_TRUE(RepeatedStringMessage::protobufMetaObject.typedSerializer != nullptr);
+
+    //Messages without fields and messages that contain only maps, repeated messages or repeated enums
+    //are serialized using reflection
+    ASSERT_TRUE(EmptyMessage::protobufMetaObject.typedSerializer == nullptr);
+    ASSERT_TRUE(SimpleEnumListMessage::protobufMetaObject.typedSerializer == nullptr);
+    ASSERT_TRUE(RepeatedComplexMessage::protobufMetaObject.typedSerializer == nullptr);
+    ASSERT_TRUE(SimpleSInt32StringMapMessage::protobufMetaObject.typedSerializer == nullptr);
+}
+
+TEST_F(TypedSerializerTest, FieldNumberOrderTest)
+{
+    ComplexMessage test;
+    test.setTestFieldInt(42);
+    test.setTestComplexField(SimpleStringMessage{"qwerty"});
+
+    QByteArray result = test.serialize(serializer.get());
+    ASSERT_STREQ(result.toHex().toStdString().c_str(), "082a12083206717765727479");
+}
+
+TEST_F(TypedSerializerTest, NullStringSkipTest)
+{
+    SimpleStringMessage test;
+    ASSERT_TRUE(test.serialize(serializer.get()).isEmpty());
+
+    test.setTestFieldString(QString(""));
+    ASSERT_STREQ(test.serialize(serializer.get()).toHex().toStdString().c_str(), "3200");
+}
+
+TEST_F(TypedSerializerTest, UnknownFieldSkipTest)
+{
+    SimpleIntMessage test;
+    test.deserialize(serializer.get(), QByteArray::fromHex("120571776572741a0208012001089601"));
+    ASSERT_EQ(test.testFieldInt(), 150);
+}
+
+TEST_F(TypedSerializerTest, RoundtripTest)
+{
+    ComplexMessage test;
+    test.setTestFieldInt(-45);
+    test.setTestComplexField(SimpleStringMessage{"qwerty"});
+
+    ComplexMessage result;
+    result.deserialize(serializer.get(), test.serialize(serializer.get()));
+    ASSERT_TRUE(result == test);
+
+    RepeatedStringMessage listTest;
+    listTest.setTestRepeatedString({"aaaaa", "bbbbb", "", "ccccc"});
+
+    RepeatedStringMessage listResult;
+    listResult.deserialize(serializer.get(), listTest.serialize(serializer.get()));
+    ASSERT_TRUE(listResult.testRepeatedString() == listTest.testRepeatedString());
+}
+
+} // tests
+} // qtprotobuf
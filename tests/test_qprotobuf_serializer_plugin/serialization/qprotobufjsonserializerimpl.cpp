@@ -40,12 +40,13 @@ QByteArray QProtobufJsonSerializerImpl::serializeMessage(const QObject *object,
     return QByteArray();
 }
 
-void QProtobufJsonSerializerImpl::deserializeMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject,
+bool QProtobufJsonSerializerImpl::deserializeMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject,
                                                      const QByteArray &data) const
 {
     Q_UNUSED(object)
     Q_UNUSED(data)
     Q_UNUSED(metaObject)
+    return true;
 }
 
 QByteArray QProtobufJsonSerializerImpl::serializeObject(const QObject *object,
@@ -57,13 +58,14 @@ QByteArray QProtobufJsonSerializerImpl::serializeObject(const QObject *object,
     return QByteArray();
 }
 
-void QProtobufJsonSerializerImpl::deserializeObject(QObject *object,
+bool QProtobufJsonSerializerImpl::deserializeObject(QObject *object,
                                                     const QtProtobuf::QProtobufMetaObject &metaObject,
                                                     QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(object)
     Q_UNUSED(it)
     Q_UNUSED(metaObject)
+    return true;
 }
 
 QByteArray QProtobufJsonSerializerImpl::serializeListObject(const QObject *object,
@@ -124,20 +126,22 @@ QByteArray QProtobufJsonSerializerImpl::serializeEnumList(const QList<QtProtobuf
     return QByteArray();
 }
 
-void QProtobufJsonSerializerImpl::deserializeEnum(QtProtobuf::int64 &value,
+bool QProtobufJsonSerializerImpl::deserializeEnum(QtProtobuf::int64 &value,
                                                   const QMetaEnum &metaEnum,
                                                   QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(value)
     Q_UNUSED(metaEnum)
     Q_UNUSED(it)
+    return true;
 }
 
-void QProtobufJsonSerializerImpl::deserializeEnumList(QList<QtProtobuf::int64> &value,
+bool QProtobufJsonSerializerImpl::deserializeEnumList(QList<QtProtobuf::int64> &value,
                                                       const QMetaEnum &metaEnum,
                                                       QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(value)
     Q_UNUSED(metaEnum)
     Q_UNUSED(it)
+    return true;
 }
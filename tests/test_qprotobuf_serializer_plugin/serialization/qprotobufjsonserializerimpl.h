@@ -43,10 +43,10 @@ public:
 
 protected:
     QByteArray serializeMessage(const QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject) const  override;
-    void deserializeMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QByteArray &data) const override;
+    bool deserializeMessage(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QByteArray &data) const override;
 
     QByteArray serializeObject(const QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
-    void deserializeObject(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
+    bool deserializeObject(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
 
     QByteArray serializeListObject(const QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
     bool deserializeListObject(QObject *object, const QtProtobuf::QProtobufMetaObject &metaObject, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
@@ -57,6 +57,6 @@ protected:
     QByteArray serializeEnum(QtProtobuf::int64 value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
     QByteArray serializeEnumList(const QList<QtProtobuf::int64> &value, const QMetaEnum &metaEnum, const QtProtobuf::QProtobufMetaProperty &metaProperty) const override;
 
-    void deserializeEnum(QtProtobuf::int64 &value, const QMetaEnum &metaEnum, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
-    void deserializeEnumList(QList<QtProtobuf::int64> &value, const QMetaEnum &metaEnum, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnum(QtProtobuf::int64 &value, const QMetaEnum &metaEnum, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
+    bool deserializeEnumList(QList<QtProtobuf::int64> &value, const QMetaEnum &metaEnum, QtProtobuf::QProtobufSelfcheckIterator &it) const override;
 };
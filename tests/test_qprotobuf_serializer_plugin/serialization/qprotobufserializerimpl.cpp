@@ -43,13 +43,14 @@ QByteArray QProtobufSerializerImpl::serializeMessage(const QObject *object,
     return QByteArray();
 }
 
-void QProtobufSerializerImpl::deserializeMessage(QObject *object,
+bool QProtobufSerializerImpl::deserializeMessage(QObject *object,
                                                  const QtProtobuf::QProtobufMetaObject &metaObject,
                                                  const QByteArray &data) const
 {
     Q_UNUSED(object)
     Q_UNUSED(data)
     Q_UNUSED(metaObject)
+    return true;
 }
 
 QByteArray QProtobufSerializerImpl::serializeObject(const QObject *object,
@@ -62,13 +63,14 @@ QByteArray QProtobufSerializerImpl::serializeObject(const QObject *object,
     return QByteArray();
 }
 
-void QProtobufSerializerImpl::deserializeObject(QObject *object,
+bool QProtobufSerializerImpl::deserializeObject(QObject *object,
                                                 const QtProtobuf::QProtobufMetaObject &metaObject,
                                                 QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(object)
     Q_UNUSED(it)
     Q_UNUSED(metaObject)
+    return true;
 }
 
 QByteArray QProtobufSerializerImpl::serializeListObject(const QObject *object,
@@ -124,18 +126,20 @@ QByteArray QProtobufSerializerImpl::serializeEnumList(const QList<QtProtobuf::in
     return QByteArray();
 }
 
-void QProtobufSerializerImpl::deserializeEnum(QtProtobuf::int64 &value,
+bool QProtobufSerializerImpl::deserializeEnum(QtProtobuf::int64 &value,
                                               const QMetaEnum &/*metaEnum*/,
                                               QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(value)
     Q_UNUSED(it)
+    return true;
 }
 
-void QProtobufSerializerImpl::deserializeEnumList(QList<QtProtobuf::int64> &value,
+bool QProtobufSerializerImpl::deserializeEnumList(QList<QtProtobuf::int64> &value,
                                                   const QMetaEnum &/*metaEnum*/,
                                                   QtProtobuf::QProtobufSelfcheckIterator &it) const
 {
     Q_UNUSED(value)
     Q_UNUSED(it)
+    return true;
 }